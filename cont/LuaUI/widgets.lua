@@ -130,6 +130,7 @@ local flexCallIns = {
   'UnitCommand',
   'UnitCmdDone',
   'UnitDamaged',
+  'UnitDamagedBatch',
   'UnitStunned',
   'UnitEnteredRadar',
   'UnitEnteredLos',
@@ -1913,6 +1914,13 @@ function widgetHandler:UnitDamaged(unitID, unitDefID, unitTeam, damage, paralyze
   return
 end
 
+function widgetHandler:UnitDamagedBatch(count, unitIDs, unitDefIDs, unitTeams, damages, paralyzers, weaponDefIDs, projectileIDs, attackerIDs, attackerDefIDs, attackerTeams)
+  for _,w in ipairs(self.UnitDamagedBatchList) do
+    w:UnitDamagedBatch(count, unitIDs, unitDefIDs, unitTeams, damages, paralyzers, weaponDefIDs, projectileIDs, attackerIDs, attackerDefIDs, attackerTeams)
+  end
+  return
+end
+
 function widgetHandler:UnitStunned(unitID, unitDefID, unitTeam, stunned)
   for _,w in ipairs(self.UnitStunnedList) do
     w:UnitStunned(unitID, unitDefID, unitTeam, stunned)
@@ -1510,6 +1510,26 @@ function gadgetHandler:UnitDamaged(
   end
 end
 
+function gadgetHandler:UnitDamagedBatch(
+  count,
+  unitIDs,
+  unitDefIDs,
+  unitTeams,
+  damages,
+  paralyzers,
+  weaponDefIDs,
+  projectileIDs,
+  attackerIDs,
+  attackerDefIDs,
+  attackerTeams
+)
+  for _,g in r_ipairs(self.UnitDamagedBatchList) do
+    g:UnitDamagedBatch(count, unitIDs, unitDefIDs, unitTeams,
+                       damages, paralyzers, weaponDefIDs, projectileIDs,
+                       attackerIDs, attackerDefIDs, attackerTeams)
+  end
+end
+
 function gadgetHandler:UnitStunned(unitID, unitDefID, unitTeam, stunned)
   for _,g in r_ipairs(self.UnitStunnedList) do
     g:UnitStunned(unitID, unitDefID, unitTeam, stunned)
@@ -206,12 +206,11 @@ static float getRulesParamFloatValueByName(
 	const char* rulesParamName,
 	float defaultValue
 ) {
-	const std::string key(rulesParamName);
-	const auto it = params.find(key);
-	if (it == params.end())
+	const LuaRulesParams::Param* paramPtr = params.Find(rulesParamName);
+	if (paramPtr == nullptr)
 		return defaultValue;
 
-	const LuaRulesParams::Param& param = it->second;
+	const LuaRulesParams::Param& param = *paramPtr;
 	if (!modParamIsVisible(param, losMask))
 		return defaultValue;
 
@@ -229,13 +228,12 @@ static const char* getRulesParamStringValueByName(
 	const char* rulesParamName,
 	const char* defaultValue
 ) {
-	const std::string key(rulesParamName);
-	const auto it = params.find(key);
-	if (it == params.end())
+	const LuaRulesParams::Param* paramPtr = params.Find(rulesParamName);
+	if (paramPtr == nullptr)
 		return defaultValue;
 
-	const LuaRulesParams::Param& param = it->second;
-	if (!modParamIsVisible(it->second, losMask))
+	const LuaRulesParams::Param& param = *paramPtr;
+	if (!modParamIsVisible(param, losMask))
 		return defaultValue;
 
 	if (!std::holds_alternative <std::string> (param.value))
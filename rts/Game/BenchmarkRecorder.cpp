@@ -0,0 +1,232 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+#include "BenchmarkRecorder.h"
+#include "Game/GameVersion.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/TimeProfiler.h"
+#include "System/Log/ILog.h"
+
+
+namespace {
+	struct FrameStats {
+		float mean = 0.0f;
+		float total = 0.0f;
+		float p50 = 0.0f;
+		float p90 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+	};
+
+	// nearest-rank percentile, <times> must be sorted
+	float Percentile(const std::vector<float>& times, float p) {
+		if (times.empty())
+			return 0.0f;
+
+		const size_t rank = std::ceil(p * times.size());
+		return times[std::clamp(rank, size_t(1), times.size()) - 1];
+	}
+
+	FrameStats CalcFrameStats(std::vector<float> times) {
+		FrameStats stats;
+
+		if (times.empty())
+			return stats;
+
+		std::sort(times.begin(), times.end());
+
+		stats.total = std::accumulate(times.begin(), times.end(), 0.0f);
+		stats.mean = stats.total / times.size();
+		stats.p50 = Percentile(times, 0.50f);
+		stats.p90 = Percentile(times, 0.90f);
+		stats.p95 = Percentile(times, 0.95f);
+		stats.p99 = Percentile(times, 0.99f);
+		stats.max = times.back();
+		return stats;
+	}
+
+	void WriteJSONStats(std::ofstream& out, const FrameStats& stats) {
+		out << "{";
+		out << "\"mean\": " << stats.mean << ", ";
+		out << "\"p50\": " << stats.p50 << ", ";
+		out << "\"p90\": " << stats.p90 << ", ";
+		out << "\"p95\": " << stats.p95 << ", ";
+		out << "\"p99\": " << stats.p99 << ", ";
+		out << "\"max\": " << stats.max << ", ";
+		out << "\"total\": " << stats.total;
+		out << "}";
+	}
+
+	std::string EscapeJSON(const std::string& str) {
+		std::string ret;
+		ret.reserve(str.size());
+
+		for (const char c: str) {
+			if (c == '"' || c == '\\')
+				ret += '\\';
+
+			ret += c;
+		}
+
+		return ret;
+	}
+}
+
+
+CBenchmarkRecorder::CBenchmarkRecorder(const std::string& outputName, const std::string& demoName)
+	: outputName(outputName)
+	, demoName(demoName)
+{
+	// non-special timers are no-ops while the profiler is disabled
+	CTimeProfiler::GetInstance().SetEnabled(true);
+
+	sections.reserve(64);
+	frameNums.reserve(GAME_SPEED * 60 * 60);
+	frameTimes.reserve(GAME_SPEED * 60 * 60);
+
+	LOG("[BenchmarkRecorder::%s] benchmarking demo \"%s\", results go to \"%s\"", __func__, demoName.c_str(), outputName.c_str());
+}
+
+
+void CBenchmarkRecorder::SimFrame(int frameNum, spring_time frameTime)
+{
+	CTimeProfiler::GetInstance().GetTimerTotals(timerTotals);
+
+	for (const auto& timerTotal: timerTotals) {
+		const auto iter = sectionIndices.find(timerTotal.first);
+
+		int sectionIdx = -1;
+
+		if (iter == sectionIndices.end()) {
+			const std::string name = CTimeProfiler::GetTimerName(timerTotal.first);
+
+			if (name.compare(0, 3, "Sim") == 0) {
+				// timer fired for the first time; earlier frames did not use it
+				sections.push_back({name, spring_notime, std::vector<float>(frameNums.size(), 0.0f)});
+				sectionIdx = int(sections.size()) - 1;
+			}
+
+			sectionIndices[timerTotal.first] = sectionIdx;
+		} else {
+			sectionIdx = iter->second;
+		}
+
+		if (sectionIdx < 0)
+			continue;
+
+		Section& section = sections[sectionIdx];
+
+		// profiler might have been reset (e.g. by /debuginfo)
+		if (timerTotal.second < section.lastTotal)
+			section.lastTotal = spring_notime;
+
+		section.frameTimes.push_back((timerTotal.second - section.lastTotal).toMilliSecsf());
+		section.lastTotal = timerTotal.second;
+	}
+
+	frameNums.push_back(frameNum);
+	frameTimes.push_back(frameTime.toMilliSecsf());
+
+	// sections that did not show up in this frame
+	for (Section& section: sections) {
+		section.frameTimes.resize(frameNums.size(), 0.0f);
+	}
+}
+
+
+void CBenchmarkRecorder::AddDesync(int frameNum)
+{
+	if (firstDesyncFrame < 0 || frameNum < firstDesyncFrame)
+		firstDesyncFrame = frameNum;
+
+	numDesyncs += 1;
+}
+
+
+bool CBenchmarkRecorder::WriteResults() const
+{
+	const bool csv = WriteCSV(outputName + ".csv");
+	const bool json = WriteJSON(outputName + ".json");
+
+	LOG("[BenchmarkRecorder::%s] wrote " _STPF_ " frames to \"%s\".{csv,json}", __func__, frameNums.size(), outputName.c_str());
+	return (csv && json);
+}
+
+bool CBenchmarkRecorder::WriteCSV(const std::string& fileName) const
+{
+	std::ofstream out(fileName, std::ios::out | std::ios::trunc);
+
+	if (!out.is_open()) {
+		LOG_L(L_ERROR, "[BenchmarkRecorder::%s] could not open \"%s\"", __func__, fileName.c_str());
+		return false;
+	}
+
+	out << "frame,frameTime";
+
+	for (const Section& section: sections) {
+		out << "," << section.name;
+	}
+
+	out << "\n";
+
+	for (size_t i = 0; i < frameNums.size(); i++) {
+		out << frameNums[i] << "," << frameTimes[i];
+
+		for (const Section& section: sections) {
+			out << "," << section.frameTimes[i];
+		}
+
+		out << "\n";
+	}
+
+	return out.good();
+}
+
+bool CBenchmarkRecorder::WriteJSON(const std::string& fileName) const
+{
+	std::ofstream out(fileName, std::ios::out | std::ios::trunc);
+
+	if (!out.is_open()) {
+		LOG_L(L_ERROR, "[BenchmarkRecorder::%s] could not open \"%s\"", __func__, fileName.c_str());
+		return false;
+	}
+
+	std::vector<const Section*> sortedSections;
+	sortedSections.reserve(sections.size());
+
+	for (const Section& section: sections) {
+		sortedSections.push_back(&section);
+	}
+
+	std::sort(sortedSections.begin(), sortedSections.end(), [](const Section* a, const Section* b) { return (a->name < b->name); });
+
+	out << "{\n";
+	out << "\t\"engine\": \"" << EscapeJSON(SpringVersion::GetFull()) << "\",\n";
+	out << "\t\"demo\": \"" << EscapeJSON(demoName) << "\",\n";
+	out << "\t\"frames\": " << frameNums.size() << ",\n";
+	out << "\t\"syncCheck\": " << ((numSyncChecks > 0)? "true": "false") << ",\n";
+	out << "\t\"numSyncChecks\": " << numSyncChecks << ",\n";
+	out << "\t\"firstDesyncFrame\": " << firstDesyncFrame << ",\n";
+	out << "\t\"numDesyncs\": " << numDesyncs << ",\n";
+	out << "\t\"unit\": \"ms\",\n";
+	out << "\t\"frameTime\": ";
+	WriteJSONStats(out, CalcFrameStats(frameTimes));
+	out << ",\n";
+	out << "\t\"sections\": {";
+
+	for (size_t i = 0; i < sortedSections.size(); i++) {
+		out << ((i == 0)? "\n": ",\n");
+		out << "\t\t\"" << EscapeJSON(sortedSections[i]->name) << "\": ";
+		WriteJSONStats(out, CalcFrameStats(sortedSections[i]->frameTimes));
+	}
+
+	out << "\n\t}\n";
+	out << "}\n";
+
+	return out.good();
+}
@@ -0,0 +1,71 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _BENCHMARK_RECORDER_H
+#define _BENCHMARK_RECORDER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "System/Misc/SpringTime.h"
+#include "System/UnorderedMap.hpp"
+
+/**
+ * @brief Collects per-frame simulation timings during a benchmark run
+ *
+ * Active when a demo is played back with --benchmark <name>; the server then
+ * feeds demo frames as fast as the client can simulate them. After each sim
+ * frame the accumulated time of every "Sim*" SCOPED_TIMER is sampled, at the
+ * end <name>.csv (one row per frame) and <name>.json (per-section statistics
+ * and percentiles) are written.
+ *
+ * The JSON also reports the first frame at which the local simulation did not
+ * match a sync-response recorded in the demo (-1 if none), which DemoTool's
+ * --verifydir uses to check batches of demos for desyncs. "syncCheck" is only
+ * true if any response was actually compared, i.e. the engine was built with
+ * SYNCCHECK and the demo contains responses from other players.
+ */
+class CBenchmarkRecorder
+{
+public:
+	CBenchmarkRecorder(const std::string& outputName, const std::string& demoName);
+
+	void SimFrame(int frameNum, spring_time frameTime);
+	void AddSyncCheck() { numSyncChecks += 1; }
+	void AddDesync(int frameNum);
+	bool WriteResults() const;
+
+	const std::string& GetOutputName() const { return outputName; }
+	size_t GetNumFrames() const { return frameNums.size(); }
+
+private:
+	struct Section {
+		std::string name;
+		spring_time lastTotal;
+
+		/// milliseconds per sampled frame
+		std::vector<float> frameTimes;
+	};
+
+	bool WriteCSV(const std::string& fileName) const;
+	bool WriteJSON(const std::string& fileName) const;
+
+private:
+	std::string outputName;
+	std::string demoName;
+
+	std::vector<Section> sections;
+	/// <name-hash, index into sections>; -1 for timers that are not sampled
+	spring::unordered_map<unsigned, int> sectionIndices;
+
+	std::vector<int> frameNums;
+	std::vector<float> frameTimes;
+
+	int firstDesyncFrame = -1;
+	int numDesyncs = 0;
+	int numSyncChecks = 0;
+
+	std::vector< std::pair<unsigned, spring_time> > timerTotals;
+};
+
+#endif // _BENCHMARK_RECORDER_H
@@ -18,6 +18,8 @@ public:
 	std::string myPasswd;
 	std::string saveFile;
 	std::string demoFile;
+	//! if not empty, demoFile is played back as fast as possible and timings are written to <benchmarkFile>.{csv,json}
+	std::string benchmarkFile;
 
 	//! if this client is not the server player, the IP address we connect to
 	//! if this client is the server player, the IP address that other players connect to
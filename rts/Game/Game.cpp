@@ -3,9 +3,11 @@
 #include "Rendering/GL/myGL.h"
 
 #include "Game.h"
+#include "BenchmarkRecorder.h"
 #include "Camera.h"
 #include "CameraHandler.h"
 #include "ChatMessage.h"
+#include "ClientSetup.h"
 #include "CommandMessage.h"
 #include "ConsoleHistory.h"
 #include "GameHelper.h"
@@ -124,6 +126,7 @@
 #include "System/Sound/ISound.h"
 #include "System/Sound/ISoundChannels.h"
 #include "System/Sync/DumpState.h"
+#include "System/Sync/SyncedPrimitiveBase.h"
 #include "System/TimeProfiler.h"
 #include "System/LoadLock.h"
 
@@ -214,6 +217,7 @@ CR_REG_METADATA(CGame, (
 	CR_IGNORED(curScanCodeChain),
 	CR_IGNORED(worldDrawer),
 	CR_IGNORED(saveFileHandler),
+	CR_IGNORED(benchmarkRecorder),
 
 	// Post Load
 	CR_POSTLOAD(PostLoad)
@@ -252,6 +256,11 @@ CGame::CGame(const std::string& mapFileName, const std::string& modFileName, ILo
 
 	speedControl = configHandler->GetInt("SpeedControl");
 
+	if (gameServer != nullptr && !gameServer->GetClientSetup()->benchmarkFile.empty()) {
+		const std::shared_ptr<const ClientSetup> clientSetup = gameServer->GetClientSetup();
+		benchmarkRecorder = std::make_unique<CBenchmarkRecorder>(clientSetup->benchmarkFile, clientSetup->demoFile);
+	}
+
 	playerRoster.SetSortTypeByCode((PlayerRoster::SortType)configHandler->GetInt("ShowPlayerInfo"));
 
 	CInputReceiver::guiAlpha = configHandler->GetFloat("GuiOpacity");
@@ -920,6 +929,7 @@ void CGame::KillLua(bool dtor)
 	CLuaRules::FreeHandler();
 
 	CSplitLuaHandle::ClearGameParams();
+	LuaRulesParams::ClearKeys();
 	LEAVE_SYNCED_CODE();
 
 
@@ -1171,6 +1181,14 @@ bool CGame::Update()
 	SendClientProcUsage();
 	ClientReadNet(); // issues new SimFrame()s
 
+	// benchmark is complete once the server ran out of demo data and we consumed all of it
+	if (benchmarkRecorder != nullptr && gameServer->GetDemoReader() == nullptr && clientNet->Peek(0) == nullptr) {
+		benchmarkRecorder->WriteResults();
+		benchmarkRecorder.reset();
+
+		gu->globalQuit = true;
+	}
+
 	if (!gameOver) {
 		if (clientNet->NeedsReconnect())
 			clientNet->AttemptReconnect(SpringVersion::GetSync(), Platform::GetPlatformStr());
@@ -1729,6 +1747,7 @@ void CGame::SimFrame() {
 
 		{
 			SCOPED_TIMER("Sim::GameFrame");
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_LUARULES);
 
 			// keep garbage-collection rate tied to sim-speed
 			// (fixed 30Hz gc is not enough while catching up)
@@ -1739,27 +1758,57 @@ void CGame::SimFrame() {
 		}
 
 		helper->Update();
-		readMap->Update();
-		smoothGround.UpdateSmoothMesh();
-		mapDamage->Update();
-		unitHandler.Update();
-		pathManager->Update();
-		projectileHandler.Update();
-		featureHandler.Update();
+		{
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_MAP);
+			readMap->Update();
+			smoothGround.UpdateSmoothMesh();
+			mapDamage->Update();
+		}
+		{
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_UNITS);
+			unitHandler.Update();
+		}
+		{
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_PATHING);
+			pathManager->Update();
+		}
+		{
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_PROJECTILES);
+			projectileHandler.Update();
+		}
+		{
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_FEATURES);
+			featureHandler.Update();
+		}
 		{
 			SCOPED_TIMER("Sim::Script");
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_UNITS);
 			unitScriptEngine->Tick(33);
 		}
 		envResHandler.Update();
-		losHandler->Update();
+		{
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_LOS);
+			losHandler->Update();
+		}
 		// dead ghosts have to be updated in sim, after los,
 		// to make sure they represent the current knowledge correctly.
 		// should probably be split from drawer
 		CUnitDrawer::UpdateGhostedBuildings();
-		interceptHandler.Update(false);
+		{
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_PROJECTILES);
+			interceptHandler.Update(false);
+		}
 
 		teamHandler.GameFrame(gs->frameNum);
 		playerHandler.GameFrame(gs->frameNum);
+
+		{
+			SCOPED_TIMER("Sim::BatchedEvents");
+			SYNC_CATEGORY_SCOPE(SYNC_CATEGORY_LUARULES);
+
+			// once per frame instead of once per event
+			eventHandler.DeliverBatchedEvents();
+		}
 	}
 
 	lastSimFrameTime = spring_gettime();
@@ -1770,8 +1819,11 @@ void CGame::SimFrame() {
 
 	FrameMarkEnd(tracingSimFrameName);
 
+	if (benchmarkRecorder != nullptr)
+		benchmarkRecorder->SimFrame(gs->frameNum, lastSimFrameTime - lastFrameTime);
+
 	#ifdef HEADLESS
-	{
+	if (benchmarkRecorder == nullptr) {
 		const float msecMaxSimFrameTime = 1000.0f / (GAME_SPEED * gs->wantedSpeedFactor);
 		const float msecDifSimFrameTime = (lastSimFrameTime - lastFrameTime).toMilliSecsf();
 		// multiply by 0.5 to give unsynced code some execution time (50% of our sleep-budget)
@@ -1786,6 +1838,14 @@ void CGame::SimFrame() {
 	// useful for desync-debugging (enter instead of -1 start & end frame of the range you want to debug)
 	DumpState(-1, -1, 1, std::nullopt);
 
+#ifdef SYNCCHECK
+	{
+		// the generator state is not a synced primitive, fold it in explicitly
+		const auto rngState = gsRNG.GetGenState();
+		CSyncChecker::Sync(SYNC_CATEGORY_RNG, &rngState, sizeof(rngState));
+	}
+#endif
+
 	ASSERT_SYNCED(gsRNG.GetGenState());
 	LEAVE_SYNCED_CODE();
 }
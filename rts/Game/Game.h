@@ -4,6 +4,7 @@
 #define _GAME_H
 
 #include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -19,6 +20,7 @@
 class LuaParser;
 class ILoadSaveHandler;
 class ChatMessage;
+class CBenchmarkRecorder;
 
 
 class CGame : public CGameController
@@ -227,6 +229,9 @@ private:
 	/// for reloading the savefile
 	ILoadSaveHandler* saveFileHandler;
 
+	/// non-null when playing back a demo with --benchmark
+	std::unique_ptr<CBenchmarkRecorder> benchmarkRecorder;
+
 	std::atomic<bool> loadDone = {false};
 	std::atomic<bool> gameOver = {false};
 };
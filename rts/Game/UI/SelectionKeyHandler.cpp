@@ -210,11 +210,11 @@ namespace {
 		{ }
 
 		bool ShouldIncludeUnit(const CUnit* unit) const override {
-			const auto it = unit->modParams.find(paramName);
-			if (it == unit->modParams.end())
+			const auto* paramPtr = unit->modParams.Find(paramName);
+			if (paramPtr == nullptr)
 				return false;
 
-			const auto& param = it->second;
+			const auto& param = *paramPtr;
 			if (!wantedValueStr.empty()) {
 				if (std::holds_alternative <std::string> (param.value))
 					return std::get <std::string> (param.value) == wantedValueStr;
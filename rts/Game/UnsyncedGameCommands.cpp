@@ -51,6 +51,7 @@
 #include "Lua/LuaOpenGL.h"
 #include "Lua/LuaUI.h"
 #include "Lua/LuaMenu.h"
+#include "Lua/LuaProfiler.h"
 
 #include "Map/Ground.h"
 #include "Map/MetalMap.h"
@@ -1741,6 +1742,45 @@ public:
 
 
 
+class LuaProfilerActionExecutor: public IUnsyncedActionExecutor {
+public:
+	LuaProfilerActionExecutor() : IUnsyncedActionExecutor(
+		"LuaProfiler",
+		"Toggle the Lua call-in profiler, turning it off writes the results; also takes on, off, write and clear, optionally followed by an output base-name"
+	) {}
+
+	bool Execute(const UnsyncedAction& action) const final {
+		CLuaProfiler& profiler = CLuaProfiler::GetInstance();
+
+		const std::vector<std::string> args = CSimpleParser::Tokenize(action.GetArgs());
+		const std::string cmd = args.empty()? (profiler.IsEnabled()? "off": "on"): StringToLower(args[0]);
+		const std::string outName = (args.size() > 1)? args[1]: "luaprofile";
+
+		if (cmd == "on") {
+			profiler.Enable();
+			LOG("Lua profiler enabled");
+			return true;
+		}
+		if (cmd == "off" || cmd == "write") {
+			if (cmd == "off") {
+				profiler.Disable();
+				LOG("Lua profiler disabled");
+			}
+
+			profiler.LogSummary(20);
+			profiler.WriteFolded(outName);
+			return true;
+		}
+		if (cmd == "clear") {
+			profiler.Clear();
+			return true;
+		}
+
+		return false;
+	}
+};
+
+
 
 class GameInfoActionExecutor : public IUnsyncedActionExecutor {
 public:
@@ -3988,6 +4028,7 @@ void UnsyncedGameCommands::AddDefaultActionExecutors()
 	AddActionExecutor(AllocActionExecutor<LuaUIActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<LuaMenuActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<LuaGarbageCollectControlExecutor>());
+	AddActionExecutor(AllocActionExecutor<LuaProfilerActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<MiniMapActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<GroundDecalsActionExecutor>());
 
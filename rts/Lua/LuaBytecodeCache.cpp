@@ -0,0 +1,166 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+
+#include "LuaBytecodeCache.h"
+#include "LuaInclude.h"
+#include "Game/GameVersion.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+#include "System/SpringHash.h"
+
+CONFIG(bool, LuaBytecodeCache)
+	.defaultValue(false)
+	.headlessValue(true)
+	.dedicatedValue(true)
+	.description("Store compiled Lua chunks in the cache directory and load them from there as long as their source is unchanged. Only available in headless and dedicated builds.");
+
+
+// anything a compiled chunk depends on besides its source; Lua's own header
+// only covers type sizes and the bytecode format version
+static const std::string& GetBuildStamp()
+{
+	static const std::string stamp = std::string(LUA_RELEASE) + " " + SpringVersion::GetFull() + " " + std::to_string(sizeof(lua_Number) * 8) + "\n";
+	return stamp;
+}
+
+static const std::string& GetCacheDir()
+{
+	// empty if the directory could not be created
+	static const std::string cacheDir = dataDirsAccess.LocateDir(FileSystem::GetCacheDir() + FileSystemAbstraction::GetNativePathSeparator() + "lua" + FileSystemAbstraction::GetNativePathSeparator(), FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+	return cacheDir;
+}
+
+static bool IsEnabled()
+{
+#if defined(HEADLESS) || defined(DEDICATED)
+	return (configHandler != nullptr && configHandler->GetBool("LuaBytecodeCache") && !GetCacheDir().empty());
+#else
+	// cached chunks bypass the parser and go straight to the undumper,
+	// which trusts its input; keep that off player-facing builds
+	return false;
+#endif
+}
+
+
+static std::string GetHexDigest(const void* data, size_t size)
+{
+	// not cryptographic, only catches damaged entries; Lua code itself is
+	// kept from writing into the cache directory by LuaIO::SafeWritePath
+	const XXH128_hash_t hash = XXH3_128bits(data, size);
+
+	char buf[33];
+	std::snprintf(buf, sizeof(buf), "%016" PRIx64 "%016" PRIx64, uint64_t(hash.high64), uint64_t(hash.low64));
+	return buf;
+}
+
+static std::string GetCacheFileName(const char* code, size_t size, const char* chunkName)
+{
+	// the chunk name is compiled into the bytecode (for error messages and
+	// debug info), identical files loaded under different names are kept
+	// apart
+	std::string key = GetHexDigest(code, size);
+
+	key += chunkName;
+	key += GetBuildStamp();
+
+	return (GetCacheDir() + GetHexDigest(key.data(), key.size()) + ".luac");
+}
+
+
+static int WriteChunk(lua_State* L, const void* data, size_t size, void* ud)
+{
+	static_cast<std::string*>(ud)->append(static_cast<const char*>(data), size);
+	return 0;
+}
+
+static bool ReadCacheFile(const std::string& fileName, std::string& bytecode)
+{
+	std::ifstream file(fileName, std::ios::in | std::ios::binary);
+
+	if (!file.is_open())
+		return false;
+
+	std::string stamp;
+	std::string digest;
+
+	std::getline(file, stamp);
+	std::getline(file, digest);
+
+	if (!file.good() || (stamp + "\n") != GetBuildStamp())
+		return false;
+
+	bytecode.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	// the undumper does not verify what it loads, never give it a damaged file
+	return (!bytecode.empty() && digest == GetHexDigest(bytecode.data(), bytecode.size()));
+}
+
+static void WriteCacheFile(const std::string& fileName, const std::string& bytecode)
+{
+	// written under a unique name and moved into place, so concurrent
+	// engine instances never read a partially written entry
+	const std::string tempName = fileName + "." + std::to_string(spring_gettime().toNanoSecsi()) + "-" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	{
+		std::ofstream file(tempName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open())
+			return;
+
+		file << GetBuildStamp();
+		file << GetHexDigest(bytecode.data(), bytecode.size()) << "\n";
+		file.write(bytecode.data(), bytecode.size());
+
+		if (!file.good()) {
+			file.close();
+			std::remove(tempName.c_str());
+			return;
+		}
+	}
+
+	// fails if another instance got there first, its entry is just as good
+	if (std::rename(tempName.c_str(), fileName.c_str()) != 0)
+		std::remove(tempName.c_str());
+}
+
+
+int LuaBytecodeCache::LoadBuffer(lua_State* L, const char* code, size_t size, const char* chunkName)
+{
+	// precompiled chunks are loaded as they are
+	if ((size > 0 && code[0] == LUA_SIGNATURE[0]) || !IsEnabled())
+		return (luaL_loadbuffer(L, code, size, chunkName));
+
+	const std::string fileName = GetCacheFileName(code, size, chunkName);
+
+	std::string bytecode;
+
+	if (ReadCacheFile(fileName, bytecode)) {
+		if (luaL_loadbuffer(L, bytecode.data(), bytecode.size(), chunkName) == 0)
+			return 0;
+
+		LOG_L(L_WARNING, "[LuaBytecodeCache::%s] could not load cached chunk \"%s\" (%s), recompiling", __func__, chunkName, lua_tostring(L, -1));
+		lua_pop(L, 1);
+	}
+
+	const int error = luaL_loadbuffer(L, code, size, chunkName);
+
+	if (error != 0)
+		return error;
+
+	bytecode.clear();
+
+	if (lua_dump(L, WriteChunk, &bytecode) == 0)
+		WriteCacheFile(fileName, bytecode);
+
+	return 0;
+}
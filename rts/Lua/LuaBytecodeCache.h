@@ -0,0 +1,30 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_BYTECODE_CACHE_H
+#define LUA_BYTECODE_CACHE_H
+
+#include <cstddef>
+#include <string>
+
+struct lua_State;
+
+/**
+ * @brief On-disk cache of compiled Lua chunks
+ *
+ * Entries live in <cachedir>/lua/ and are named after a hash of the chunk's
+ * source, its name and the engine build, so edited files and other engine
+ * versions simply miss. Each entry also records the build it was written by
+ * and a hash of its bytecode, which are checked before anything is handed
+ * to the undumper.
+ * Only enabled in headless and dedicated builds (see LuaBytecodeCache config).
+ */
+class LuaBytecodeCache {
+	public:
+		/// drop-in for luaL_loadbuffer; loads the compiled chunk if cached, otherwise compiles <code> and stores it
+		static int LoadBuffer(lua_State* L, const char* code, size_t size, const char* chunkName);
+		static int LoadBuffer(lua_State* L, const std::string& code, const std::string& chunkName) {
+			return (LoadBuffer(L, code.data(), code.size(), chunkName.c_str()));
+		}
+};
+
+#endif /* LUA_BYTECODE_CACHE_H */
@@ -3,6 +3,7 @@
 #ifndef SPRING_LUA_GARBAGE_COLLECT_CTRL_H
 #define SPRING_LUA_GARBAGE_COLLECT_CTRL_H
 
+#include <cstdint>
 #include <limits>
 
 struct SLuaGarbageCollectCtrl {
@@ -20,6 +21,24 @@ struct SLuaGarbageCollectCtrl {
 
 	float baseRunTimeMult = 0.0f;
 	float baseMemLoadMult = 0.0f;
+
+	// milliseconds per second all handles together may spend on (non-forced)
+	// collection, shared out by allocation rate; 0 disables budgeting
+	float budgetRunTime = 0.0f;
+	// unspent part of this handle's share, in milliseconds
+	float budgetBalance = 0.0f;
+
+	// allocation rate in KB/s (smoothed), from the handle's alloc-state
+	// growth between collections
+	float allocRate = 0.0f;
+	uint64_t lastAllocedBytes = 0;
+	int64_t lastCollectTime = 0; // microseconds
+
+	// statistics, exposed through Spring.GetLuaGCStats
+	uint64_t numCollections = 0;
+	uint64_t numBytesFreed = 0;
+	float totalRunTime = 0.0f; // milliseconds
+	float lastRunTime = 0.0f;
 };
 
 #endif
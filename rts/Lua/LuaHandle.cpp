@@ -6,12 +6,14 @@
 #include "LuaRules.h"
 #include "LuaUI.h"
 
+#include "LuaBytecodeCache.h"
 #include "LuaCallInCheck.h"
 #include "LuaConfig.h"
 #include "LuaHashString.h"
 #include "LuaOpenGL.h"
 #include "LuaBitOps.h"
 #include "LuaMathExtra.h"
+#include "LuaProfiler.h"
 #include "LuaUtils.h"
 #include "LuaZip.h"
 #include "Game/Game.h"
@@ -30,6 +32,7 @@
 #include "Sim/Features/FeatureDef.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
+#include "Sim/Units/UnitHandler.h"
 #include "Sim/Weapons/Weapon.h"
 #include "Sim/Weapons/WeaponDef.h"
 #include "System/creg/SerializeLuaState.h"
@@ -59,6 +62,7 @@
 
 CONFIG(float, LuaGarbageCollectionMemLoadMult).defaultValue(1.33f).minimumValue(1.0f).maximumValue(100.0f).description("How much the amount of Lua memory in use increases the rate of garbage collection.");
 CONFIG(float, LuaGarbageCollectionRunTimeMult).defaultValue(5.0f).minimumValue(1.0f).description("How many milliseconds the garbage collected can run for in each GC cycle");
+CONFIG(float, LuaGarbageCollectionBudget).defaultValue(0.0f).minimumValue(0.0f).description("Milliseconds per second all Lua states together may spend on garbage collection, shared out by how fast each state allocates; states over budget still collect under memory pressure. 0 uses LuaGarbageCollectionMemLoadMult and LuaGarbageCollectionRunTimeMult instead.");
 
 
 static spring::unsynced_set<const luaContextData*>    SYNCED_LUAHANDLE_CONTEXTS;
@@ -119,17 +123,17 @@ CLuaHandle::CLuaHandle(const string& _name, int _order, bool _userMode, bool _sy
 	: CEventClient(_name, _order, _synced)
 	, userMode(_userMode)
 	, killMe(false)
-	// no shared pool for LuaIntro to protect against LoadingMT=1
-	// do not use it for LuaMenu either; too many blocks allocated
-	// by *other* states end up not being recycled which presently
-	// forces clearing the shared pool on reload
-	, D(_name != "LuaIntro" && name != "LuaMenu", true)
+	// every state gets its own pool so its slabs can be released in
+	// bulk on reload without touching blocks of the others, and so
+	// LuaIntro may run on the loading thread (LoadingMT=1)
+	, D(false, true)
 {
 	D.owner = this;
 	D.synced = _synced;
 
 	D.gcCtrl.baseMemLoadMult = configHandler->GetFloat("LuaGarbageCollectionMemLoadMult");
 	D.gcCtrl.baseRunTimeMult = configHandler->GetFloat("LuaGarbageCollectionRunTimeMult");
+	D.gcCtrl.budgetRunTime = configHandler->GetFloat("LuaGarbageCollectionBudget");
 
 	L = LUA_OPEN(&D);
 	L_GC = lua_newthread(L);
@@ -177,6 +181,7 @@ void CLuaHandle::KillLua(bool inFreeHandler)
 	// must be done here: if called from a ctor, we want the
 	// state to become non-valid so that LoadHandler returns
 	// false and FreeHandler runs next
+	CLuaProfiler::GetInstance().RemoveState(&D);
 	LUA_ERASE_CONTEXT(&D, LUAHANDLE_CONTEXTS[D.synced]);
 	LUA_CLOSE(&L);
 }
@@ -349,7 +354,9 @@ int CLuaHandle::RunCallInTraceback(
 			// note1: disable GC outside of this scope to prevent sync errors and similar
 			// note2: we collect garbage now in its own callin "CollectGarbage"
 			// lua_gc(L, LUA_GCRESTART, 0);
+			CLuaProfiler::GetInstance().EnterCallIn(handle, state, luaFunc);
 			error = lua_pcall(state, nInArgs, nOutArgs, errFuncIdx);
+			CLuaProfiler::GetInstance().LeaveCallIn(state);
 			// only run GC inside of "SetHandleRunning(L, true) ... SetHandleRunning(L, false)"!
 			lua_gc(state, LUA_GCSTOP, 0);
 
@@ -488,7 +495,7 @@ bool CLuaHandle::LoadCode(lua_State* L, std::string code, const string& debug)
 	const LuaUtils::ScopedDebugTraceBack traceBack(L);
 
 	tracy::LuaRemove(code.data());
-	const int error = luaL_loadbuffer(L, code.c_str(), code.size(), debug.c_str());
+	const int error = LuaBytecodeCache::LoadBuffer(L, code, debug);
 
 	if (error != 0) {
 		LOG_L(L_ERROR, "[%s::%s] error=%i (%s) debug=%s msg=%s", name.c_str(), __func__, error, LuaErrorString(error), debug.c_str(), lua_tostring(L, -1));
@@ -1245,6 +1252,95 @@ void CLuaHandle::UnitDamaged(
 	RunCallInTraceback(L, cmdStr, argCount, 0, traceBack.GetErrFuncIdx(), false);
 }
 
+/*** Called once at the end of each game frame with all UnitDamaged events of that frame.
+ *
+ * Batched alternative to UnitDamaged for handlers that deal with many events
+ * per frame; event `i` is described by the `i`-th entry of every array. An
+ * attacker that is dead or not visible by the end of the frame is reported
+ * as -1, except to handlers with full read access.
+ *
+ * @function UnitDamagedBatch
+ * @number count
+ * @tparam {number,...} unitIDs
+ * @tparam {number,...} unitDefIDs
+ * @tparam {number,...} unitTeams
+ * @tparam {number,...} damages
+ * @tparam {bool,...} paralyzers
+ * @tparam {number,...} weaponDefIDs
+ * @tparam {number,...} projectileIDs
+ * @tparam {number,...} attackerIDs
+ * @tparam {number,...} attackerDefIDs
+ * @tparam {number,...} attackerTeams
+ */
+void CLuaHandle::UnitDamagedBatch(const std::vector<UnitDamagedEvent>& events)
+{
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 14, __func__);
+
+	static const LuaHashString cmdStr(__func__);
+	const LuaUtils::ScopedDebugTraceBack traceBack(L);
+
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	const int numEvents = events.size();
+
+	lua_pushnumber(L, numEvents);
+
+	#define PUSH_EVENT_ARRAY(pushFunc, expr)        \
+		lua_createtable(L, numEvents, 0);           \
+		for (int i = 0; i < numEvents; i++) {       \
+			const UnitDamagedEvent& e = events[i];  \
+			pushFunc(L, expr);                      \
+			lua_rawseti(L, -2, i + 1);              \
+		}
+
+	PUSH_EVENT_ARRAY(lua_pushnumber, e.unitID)
+	PUSH_EVENT_ARRAY(lua_pushnumber, e.unitDefID)
+	PUSH_EVENT_ARRAY(lua_pushnumber, e.unitTeam)
+	PUSH_EVENT_ARRAY(lua_pushnumber, e.damage)
+	PUSH_EVENT_ARRAY(lua_pushboolean, e.paralyzer)
+	PUSH_EVENT_ARRAY(lua_pushnumber, e.weaponDefID)
+	PUSH_EVENT_ARRAY(lua_pushnumber, e.projectileID)
+	#undef PUSH_EVENT_ARRAY
+
+	// same visibility rules as PushAttackerInfo, evaluated at delivery time
+	const bool fullRead = GetFullRead();
+
+	lua_createtable(L, numEvents, 0);
+	lua_createtable(L, numEvents, 0);
+	lua_createtable(L, numEvents, 0);
+
+	for (int i = 0; i < numEvents; i++) {
+		const UnitDamagedEvent& e = events[i];
+		const CUnit* attacker = (e.attackerID >= 0)? unitHandler.GetUnit(e.attackerID): nullptr;
+
+		int attackerID = -1;
+		int attackerDefID = -1;
+		int attackerTeam = -1;
+
+		if (fullRead) {
+			attackerID = e.attackerID;
+			attackerDefID = e.attackerDefID;
+			attackerTeam = e.attackerTeam;
+		} else if (attacker != nullptr && LuaUtils::IsUnitVisible(L, attacker)) {
+			attackerID = e.attackerID;
+			attackerDefID = LuaUtils::IsUnitTyped(L, attacker)? LuaUtils::EffectiveUnitDef(L, attacker)->id: -1;
+			attackerTeam = e.attackerTeam;
+		}
+
+		lua_pushnumber(L, attackerID);
+		lua_rawseti(L, -4, i + 1);
+		lua_pushnumber(L, attackerDefID);
+		lua_rawseti(L, -3, i + 1);
+		lua_pushnumber(L, attackerTeam);
+		lua_rawseti(L, -2, i + 1);
+	}
+
+	// call the routine
+	RunCallInTraceback(L, cmdStr, 1 + 10, 0, traceBack.GetErrFuncIdx(), false);
+}
+
 /*** Called when a unit changes its stun status.
  *
  * @function UnitStunned
@@ -3550,13 +3646,65 @@ void CLuaHandle::DownloadProgress(int ID, long downloaded, long total)
 /******************************************************************************/
 /******************************************************************************/
 
+// sum of the (weighted) allocation rates of all handles, see CollectGarbage
+static float GetTotalGCAllocRate()
+{
+	float totalAllocRate = 0.0f;
+
+	for (const auto* contexts: LUAHANDLE_CONTEXTS) {
+		for (const luaContextData* lcd: *contexts) {
+			totalAllocRate += (lcd->gcCtrl.allocRate + 1.0f);
+		}
+	}
+
+	return totalAllocRate;
+}
+
 void CLuaHandle::CollectGarbage(bool forced)
 {
-	const float gcMemLoadMult = D.gcCtrl.baseMemLoadMult;
-	const float gcRunTimeMult = D.gcCtrl.baseRunTimeMult;
+	SLuaGarbageCollectCtrl& gcCtrl = D.gcCtrl;
 
-	if (!forced && spring_lua_alloc_skip_gc(gcMemLoadMult))
-		return;
+	const float gcMemLoadMult = gcCtrl.baseMemLoadMult;
+	const float gcRunTimeMult = gcCtrl.baseRunTimeMult;
+	      bool  gcUseBudget = (!forced && gcCtrl.budgetRunTime > 0.0f);
+
+	const spring_time callTime = spring_gettime();
+	const float callDeltaSecs = (gcCtrl.lastCollectTime > 0)? ((callTime.toMicroSecsi() - gcCtrl.lastCollectTime) * 1e-6f): 0.0f;
+
+	{
+		// collection only runs in here, so growth since the last call is
+		// (almost) all new allocation
+		const uint64_t allocedBytes = D.allocState.allocedBytes.load();
+
+		if (callDeltaSecs > 0.0f) {
+			const float allocedKB = (allocedBytes > gcCtrl.lastAllocedBytes)? ((allocedBytes - gcCtrl.lastAllocedBytes) / 1024.0f): 0.0f;
+			gcCtrl.allocRate = mix(gcCtrl.allocRate, allocedKB / callDeltaSecs, 0.1f);
+		}
+
+		gcCtrl.lastAllocedBytes = allocedBytes;
+		gcCtrl.lastCollectTime = callTime.toMicroSecsi();
+	}
+
+	if (gcUseBudget) {
+		// each handle accrues its share of the global budget over time, so
+		// collection work is spread over all frames that call in here
+		const float budgetShare = gcCtrl.budgetRunTime * (gcCtrl.allocRate + 1.0f) / GetTotalGCAllocRate();
+
+		gcCtrl.budgetBalance = std::min(gcCtrl.budgetBalance + budgetShare * callDeltaSecs, budgetShare * 0.1f);
+
+		// out of budget; auto-gc is stopped so memory would grow without bound
+		// if nothing else collected it, fall back to the memory-load schedule
+		// when the load says so (this run is not charged to the budget)
+		if (gcCtrl.budgetBalance <= 0.0f) {
+			if (spring_lua_alloc_skip_gc(gcMemLoadMult))
+				return;
+
+			gcUseBudget = false;
+		}
+	} else {
+		if (!forced && spring_lua_alloc_skip_gc(gcMemLoadMult))
+			return;
+	}
 
 	LUA_CALL_IN_CHECK_NAMED(L, (GetLuaContextData(L)->synced)? "Lua::CollectGarbage::Synced": "Lua::CollectGarbage::Unsynced");
 
@@ -3566,7 +3714,7 @@ void CLuaHandle::CollectGarbage(bool forced)
 	// note: total footprint INCLUDING garbage, in KB
 	int  gcMemFootPrint = lua_gc(L_GC, LUA_GCCOUNT, 0);
 	int  gcItersInBatch = 0;
-	int& gcStepsPerIter = D.gcCtrl.numStepsPerIter;
+	int& gcStepsPerIter = gcCtrl.numStepsPerIter;
 
 	// if gc runs at a fixed rate, the upper limit to base runtime will
 	// quickly be reached since Lua's footprint can easily exceed 100MB
@@ -3575,13 +3723,15 @@ void CLuaHandle::CollectGarbage(bool forced)
 	// mean too much time is spent on it, must weigh the per-call period
 	const float gcSpeedFactor = std::clamp(gs->speedFactor * (1 - gs->PreSimFrame()) * (1 - gs->paused), 1.0f, 50.0f);
 	const float gcBaseRunTime = smoothstep(10.0f, 100.0f, gcMemFootPrint / 1024);
-	const float gcLoopRunTime = std::clamp((gcBaseRunTime * gcRunTimeMult) / gcSpeedFactor, D.gcCtrl.minLoopRunTime, D.gcCtrl.maxLoopRunTime);
+	const float gcLoopRunTime = gcUseBudget?
+		std::clamp(gcCtrl.budgetBalance, gcCtrl.minLoopRunTime, gcCtrl.maxLoopRunTime):
+		std::clamp((gcBaseRunTime * gcRunTimeMult) / gcSpeedFactor, gcCtrl.minLoopRunTime, gcCtrl.maxLoopRunTime);
 
 	const spring_time startTime = spring_gettime();
 	const spring_time   endTime = startTime + spring_msecs(gcLoopRunTime);
 
 	// perform GC cycles until time runs out or iteration-limit is reached
-	while (forced || (gcItersInBatch < D.gcCtrl.itersPerBatch && spring_gettime() < endTime)) {
+	while (forced || (gcItersInBatch < gcCtrl.itersPerBatch && spring_gettime() < endTime)) {
 		gcItersInBatch++;
 
 		if (!lua_gc(L_GC, LUA_GCSTEP, gcStepsPerIter))
@@ -3605,14 +3755,28 @@ void CLuaHandle::CollectGarbage(bool forced)
 
 
 	const spring_time finishTime = spring_gettime();
+	const float gcRunTime = (finishTime - startTime).toMilliSecsf();
 
 	if (gcStepsPerIter > 1 && gcItersInBatch > 0) {
 		// runtime optimize number of steps to process in a batch
-		const float avgLoopIterTime = (finishTime - startTime).toMilliSecsf() / gcItersInBatch;
+		const float avgLoopIterTime = gcRunTime / gcItersInBatch;
 
 		gcStepsPerIter -= (avgLoopIterTime > (gcRunTimeMult * 0.150f));
 		gcStepsPerIter += (avgLoopIterTime < (gcRunTimeMult * 0.075f));
-		gcStepsPerIter  = std::clamp(gcStepsPerIter, D.gcCtrl.minStepsPerIter, D.gcCtrl.maxStepsPerIter);
+		gcStepsPerIter  = std::clamp(gcStepsPerIter, gcCtrl.minStepsPerIter, gcCtrl.maxStepsPerIter);
+	}
+
+	{
+		const uint64_t allocedBytes = D.allocState.allocedBytes.load();
+
+		if (gcUseBudget)
+			gcCtrl.budgetBalance -= gcRunTime;
+
+		gcCtrl.numCollections += 1;
+		gcCtrl.numBytesFreed += (gcCtrl.lastAllocedBytes > allocedBytes)? (gcCtrl.lastAllocedBytes - allocedBytes): 0;
+		gcCtrl.totalRunTime += gcRunTime;
+		gcCtrl.lastRunTime = gcRunTime;
+		gcCtrl.lastAllocedBytes = allocedBytes;
 	}
 
 	eventHandler.DbgTimingInfo(TIMING_GC, startTime, finishTime);
@@ -140,6 +140,7 @@ class CLuaHandle : public CEventClient
 			int projectileID,
 			bool paralyzer
 		) override;
+		void UnitDamagedBatch(const std::vector<UnitDamagedEvent>& events) override;
 		void UnitStunned(const CUnit* unit, bool stunned) override;
 		void UnitExperience(const CUnit* unit, float oldExperience) override;
 		void UnitHarvestStorageFull(const CUnit* unit) override;
@@ -111,8 +111,11 @@ bool CUnsyncedLuaHandle::Init(std::string code, const std::string& file)
 
 	LuaPushNamedCFunc(L, "loadstring", CSplitLuaHandle::LoadStringData);
 	LuaPushNamedCFunc(L, "CallAsTeam", CSplitLuaHandle::CallAsTeam);
+	LuaPushNamedCFunc(L, "GetSyncedChannel", GetSyncedChannel);
 	LuaPushNamedNumber(L, "COBSCALE",  COBSCALE);
 
+	CreateSyncedChannelMetatable(L);
+
 	// load our libraries
 	{
 		#define KILL { KillLua(); return false; }
@@ -201,6 +204,142 @@ void CUnsyncedLuaHandle::RecvFromSynced(lua_State* srcState, int args)
 	RunCallIn(L, cmdStr, args, 0);
 }
 
+
+/******************************************************************************/
+
+struct SyncedChannelView {
+	int channel;
+	int frame;
+};
+
+static const LuaSyncedChannels::Slot* CheckSyncedChannelView(lua_State* L, const LuaSyncedChannels& channels, int index, const SyncedChannelView** view)
+{
+	*view = static_cast<const SyncedChannelView*>(luaL_checkudata(L, index, "SyncedChannelView"));
+
+	const LuaSyncedChannels::Slot* slot = channels.GetReadSlot((*view)->channel, (*view)->frame);
+
+	if (slot == nullptr)
+		luaL_error(L, "synced channel view of frame %d is no longer valid", (*view)->frame);
+
+	return slot;
+}
+
+static void PushSyncedChannelValue(lua_State* L, const LuaSyncedChannels& channels, const LuaSyncedChannels::Value& value)
+{
+	switch (value.type) {
+		case LuaSyncedChannels::Value::TYPE_NUMBER: { lua_pushnumber(L, value.number); } break;
+		case LuaSyncedChannels::Value::TYPE_BOOL  : { lua_pushboolean(L, value.boolean); } break;
+		case LuaSyncedChannels::Value::TYPE_STRING: { lua_pushsstring(L, channels.GetString(value.string)); } break;
+		default: { lua_pushnil(L); } break;
+	}
+}
+
+
+bool CUnsyncedLuaHandle::CreateSyncedChannelMetatable(lua_State* L)
+{
+	luaL_newmetatable(L, "SyncedChannelView");
+	HSTR_PUSH_CFUNC(L, "__index", SyncedChannelIndex);
+	HSTR_PUSH_CFUNC(L, "__len",   SyncedChannelLength);
+	lua_pop(L, 1);
+	return true;
+}
+
+/*** Gets a read-only view of the values a synced channel received in a frame
+ *
+ * The view reads the values in place, nothing is copied until an element is
+ * accessed: `view[i]` returns the i-th value, `#view` their number,
+ * `view.frame` the frame they were written in and `view:Unpack([first [, last]])`
+ * a range of them. A view becomes invalid (and raises an error on access) once
+ * the channel's slot for its frame is reused, about 16 frames later.
+ *
+ * @function GetSyncedChannel
+ * @string name
+ * @number[opt] frame defaults to the last frame the channel was written in
+ * @treturn nil|userdata view
+ */
+int CUnsyncedLuaHandle::GetSyncedChannel(lua_State* L)
+{
+	const LuaSyncedChannels& channels = GetUnsyncedHandle(L)->base.syncedChannels;
+	const int channel = channels.GetChannel(luaL_checkstring(L, 1));
+
+	if (channel < 0)
+		return 0;
+
+	const int frame = luaL_optint(L, 2, channels.GetLastFrame(channel));
+
+	if (channels.GetReadSlot(channel, frame) == nullptr)
+		return 0;
+
+	SyncedChannelView* view = static_cast<SyncedChannelView*>(lua_newuserdata(L, sizeof(SyncedChannelView)));
+	view->channel = channel;
+	view->frame = frame;
+
+	luaL_getmetatable(L, "SyncedChannelView");
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+int CUnsyncedLuaHandle::SyncedChannelIndex(lua_State* L)
+{
+	const LuaSyncedChannels& channels = GetUnsyncedHandle(L)->base.syncedChannels;
+	const SyncedChannelView* view = nullptr;
+	const LuaSyncedChannels::Slot* slot = CheckSyncedChannelView(L, channels, 1, &view);
+
+	if (lua_israwnumber(L, 2)) {
+		const int index = lua_toint(L, 2) - 1;
+
+		if (index < 0 || index >= static_cast<int>(slot->values.size()))
+			return 0;
+
+		PushSyncedChannelValue(L, channels, slot->values[index]);
+		return 1;
+	}
+
+	const char* key = luaL_checkstring(L, 2);
+
+	if (strcmp(key, "frame") == 0) {
+		lua_pushnumber(L, view->frame);
+		return 1;
+	}
+	if (strcmp(key, "Unpack") == 0) {
+		lua_pushcfunction(L, SyncedChannelUnpack);
+		return 1;
+	}
+
+	return 0;
+}
+
+int CUnsyncedLuaHandle::SyncedChannelLength(lua_State* L)
+{
+	const LuaSyncedChannels& channels = GetUnsyncedHandle(L)->base.syncedChannels;
+	const SyncedChannelView* view = nullptr;
+
+	lua_pushnumber(L, CheckSyncedChannelView(L, channels, 1, &view)->values.size());
+	return 1;
+}
+
+int CUnsyncedLuaHandle::SyncedChannelUnpack(lua_State* L)
+{
+	const LuaSyncedChannels& channels = GetUnsyncedHandle(L)->base.syncedChannels;
+	const SyncedChannelView* view = nullptr;
+	const LuaSyncedChannels::Slot* slot = CheckSyncedChannelView(L, channels, 1, &view);
+
+	const int numValues = slot->values.size();
+	const int first = std::max(luaL_optint(L, 2, 1), 1);
+	const int last = std::min(luaL_optint(L, 3, numValues), numValues);
+
+	if (first > last)
+		return 0;
+
+	luaL_checkstack(L, last - first + 1, __func__);
+
+	for (int i = first; i <= last; i++) {
+		PushSyncedChannelValue(L, channels, slot->values[i - 1]);
+	}
+
+	return (last - first + 1);
+}
+
 /*** Custom Object Rendering
  *
  * For the following calls drawMode can be one of the following, notDrawing = 0, normalDraw = 1, shadowDraw = 2, reflectionDraw = 3, refractionDraw = 4, and finally gameDeferredDraw = 5 which was added in 102.0.
@@ -489,6 +628,7 @@ bool CSyncedLuaHandle::Init(std::string code, const std::string& file)
 
 	// add the custom file loader
 	LuaPushNamedCFunc(L, "SendToUnsynced", SendToUnsynced);
+	LuaPushNamedCFunc(L, "SendToUnsyncedChannel", SendToUnsyncedChannel);
 	LuaPushNamedCFunc(L, "CallAsTeam",     CSplitLuaHandle::CallAsTeam);
 	LuaPushNamedNumber(L, "COBSCALE",      COBSCALE);
 
@@ -1947,6 +2087,61 @@ int CSyncedLuaHandle::SendToUnsynced(lua_State* L)
 	return 0;
 }
 
+/*** Appends values to a channel the unsynced half of this handle can read in place
+ *
+ * Unlike SendToUnsynced no call-in runs and nothing is copied into the
+ * unsynced state; it fetches a view with GetSyncedChannel whenever it needs
+ * the values. Every frame starts the channel out empty. Tables are appended
+ * element by element (array part only). Strings are interned for the rest of
+ * the game, send a small set of recurring ones; at most 65536 distinct strings
+ * are accepted.
+ *
+ * @function SendToUnsyncedChannel
+ * @string name
+ * @tparam number|bool|string|table arg1
+ * @tparam number|bool|string|table argn
+ */
+int CSyncedLuaHandle::SendToUnsyncedChannel(lua_State* L)
+{
+	LuaSyncedChannels& channels = GetSyncedHandle(L)->base.syncedChannels;
+	std::vector<LuaSyncedChannels::Value>& values = channels.GetWriteValues(channels.GetOrAddChannel(luaL_checkstring(L, 1)), gs->frameNum);
+
+	const auto AppendValue = [&](int index, int arg) {
+		LuaSyncedChannels::Value value;
+
+		switch (lua_type(L, index)) {
+			case LUA_TNUMBER : { value.type = LuaSyncedChannels::Value::TYPE_NUMBER; value.number = lua_tonumber(L, index); } break;
+			case LUA_TBOOLEAN: { value.type = LuaSyncedChannels::Value::TYPE_BOOL; value.boolean = lua_toboolean(L, index); } break;
+			case LUA_TSTRING : {
+				value.type = LuaSyncedChannels::Value::TYPE_STRING;
+
+				if ((value.string = channels.InternString(lua_tostring(L, index))) < 0)
+					luaL_error(L, "Too many distinct strings for SendToUnsyncedChannel(), arg %d (max %d)", arg, LuaSyncedChannels::MAX_STRINGS);
+			} break;
+			default: {
+				luaL_error(L, "Incorrect data type for SendToUnsyncedChannel(), arg %d", arg);
+			} break;
+		}
+
+		values.push_back(value);
+	};
+
+	for (int i = 2, args = lua_gettop(L); i <= args; i++) {
+		if (!lua_istable(L, i)) {
+			AppendValue(i, i);
+			continue;
+		}
+
+		for (int j = 1, n = lua_objlen(L, i); j <= n; j++) {
+			lua_rawgeti(L, i, j);
+			AppendValue(-1, i);
+			lua_pop(L, 1);
+		}
+	}
+
+	return 0;
+}
+
 
 int CSyncedLuaHandle::AddSyncedActionFallback(lua_State* L)
 {
@@ -2208,6 +2403,9 @@ bool CSplitLuaHandle::SwapSyncedHandle(lua_State* L, lua_State* L_GC)
 	LUA_CLOSE(&syncedLuaHandle.L);
 	syncedLuaHandle.SetLuaStates(L, L_GC);
 
+	// written by the old state, the new one starts without any
+	syncedChannels.Clear();
+
 	if (!IsValid()) {
 		return false;
 	}
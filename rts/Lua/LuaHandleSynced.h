@@ -7,6 +7,7 @@
 
 #include "LuaHandle.h"
 #include "LuaRulesParams.h"
+#include "LuaSyncedChannels.h"
 #include "System/UnorderedMap.hpp"
 
 struct lua_State;
@@ -42,6 +43,14 @@ class CUnsyncedLuaHandle : public CLuaHandle
 
 	protected:
 		CSplitLuaHandle& base;
+
+	private: // call-outs
+		static int GetSyncedChannel(lua_State* L);
+
+		static bool CreateSyncedChannelMetatable(lua_State* L);
+		static int SyncedChannelIndex(lua_State* L);
+		static int SyncedChannelLength(lua_State* L);
+		static int SyncedChannelUnpack(lua_State* L);
 };
 
 
@@ -146,6 +155,7 @@ class CSyncedLuaHandle : public CLuaHandle
 		static int SyncedPairs(lua_State* L);
 
 		static int SendToUnsynced(lua_State* L);
+		static int SendToUnsyncedChannel(lua_State* L);
 
 		static int AddSyncedActionFallback(lua_State* L);
 		static int RemoveSyncedActionFallback(lua_State* L);
@@ -259,6 +269,9 @@ class CSplitLuaHandle
 		virtual std::string GetInitFileModes() const = 0;
 		virtual int GetInitSelectTeam() const = 0;
 
+		// written by the synced handle, read in place by the unsynced one
+		LuaSyncedChannels syncedChannels;
+
 		// call-outs
 		static int LoadStringData(lua_State* L);
 		static int CallAsTeam(lua_State* L);
@@ -268,7 +281,7 @@ class CSplitLuaHandle
 		CUnsyncedLuaHandle unsyncedLuaHandle;
 
 	public:
-		static void ClearGameParams() { spring::clear_unordered_map(gameParams); }
+		static void ClearGameParams() { gameParams.clear(); }
 		static const LuaRulesParams::Params& GetGameParams() { return gameParams; }
 
 	private:
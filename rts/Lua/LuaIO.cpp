@@ -44,6 +44,29 @@ static bool IsSafePath(const std::string& path)
 }
 
 
+static bool IsCachePath(const std::string& path)
+{
+	// the engine trusts what it stores in the cache directory (compiled Lua
+	// chunks are handed straight to the undumper), Lua must not write there
+	std::string normPath = StringToLower(FileSystem::GetNormalizedPath(path));
+
+	while (normPath.compare(0, 2, "./") == 0)
+		normPath.erase(0, 2);
+
+	// Windows ignores trailing dots and spaces in path components
+	std::string topDir = normPath.substr(0, normPath.find('/'));
+	topDir.erase(topDir.find_last_not_of(". ") + 1);
+
+	return (topDir == StringToLower(FileSystem::GetCacheBaseDir()));
+}
+
+
+static bool IsWriteMode(const std::string& mode)
+{
+	return (mode.find_first_of("wa+") != std::string::npos);
+}
+
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -76,6 +99,8 @@ bool LuaIO::SafeWritePath(const std::string& path)
 
 	if (std::find(std::begin(exeFiles), std::end(exeFiles), ext) != exeFiles.end())
 		return false;
+	if (IsCachePath(path))
+		return false;
 
 	return dataDirsAccess.InWriteDir(path);
 }
@@ -92,7 +117,7 @@ FILE* LuaIO::fopen(lua_State* L, const char* path, const char* mode)
 		errno = EINVAL;
 		return nullptr;
 	}
-	if (!IsSafePath(path)) {
+	if (!IsSafePath(path) || (IsWriteMode(modeStr) && !SafeWritePath(path))) {
 		errno = EPERM; //EACCESS?
 		return nullptr;
 	}
@@ -2,6 +2,7 @@
 
 #include <algorithm> // std::min
 #include <cstdint> // std::uint8_t
+#include <cstdio>
 #include <cstring> // std::mem{cpy,set}
 #include <new>
 
@@ -65,6 +66,9 @@ void LuaMemPool::ReleasePtr(LuaMemPool* p, const CLuaHandle* o)
 		return;
 	}
 
+	// the state is closed, return its slabs before the pool is recycled
+	p->Clear();
+
 	gMutex.lock();
 	gIndcs.push_back(p->GetGlobalIndex());
 	gMutex.unlock();
@@ -97,81 +101,54 @@ LuaMemPool::LuaMemPool(size_t lmpIndex): globalIndex(lmpIndex)
 
 void LuaMemPool::Clear()
 {
-	//allocStats = {};
+	if (!LuaMemPool::enabled)
+		return;
+
+	// called once the owning state is gone, all slabs can go in one sweep
+	luaMemPoolImpl->clear();
 }
 
 void* LuaMemPool::Alloc(size_t size)
 {
-	if (!LuaMemPool::enabled) {
-		allocStats[STAT_NAE] += 1 * (size > 0);
-		allocStats[STAT_NBE] += size;
-		auto t0 = spring_now();
-		void* ptr = ::operator new(size);
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-		return ptr;
-	}
-
-	auto t0 = spring_now();
-	auto* ptr = luaMemPoolImpl->allocMem(size);
-	
-	if (size > NUM_BUCKETS * BUCKET_STEP) {
-		allocStats[STAT_NAE] += 1 * (size > 0);
-		allocStats[STAT_NBE] += size;
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-	} else if (luaMemPoolImpl->isAllocInternal(ptr)) {
-		allocStats[STAT_NAI] += 1 * (size > 0);
-		allocStats[STAT_NBI] += size;
-		allocStats[STAT_NTI] += (spring_now() - t0).toMicroSecsi();
-	} else {
-		allocStats[STAT_NAF] += 1 * (size > 0);
-		allocStats[STAT_NBF] += size;
-		allocStats[STAT_NTF] += (spring_now() - t0).toMicroSecsi();
-	}
-
-	return ptr;
+	return (Realloc(nullptr, size, 0));
 }
 
 void* LuaMemPool::Realloc(void* ptr, size_t nsize, size_t osize)
 {
-	if (ptr == nullptr || osize == 0)
-		return Alloc(nsize);
+	if (ptr == nullptr)
+		osize = 0;
 
 	if (!LuaMemPool::enabled) {
+		const auto t0 = spring_now();
 		void* newPtr = ::operator new(nsize);
 
-		if (newPtr == nullptr)
-			return nullptr;
+		if (ptr != nullptr) {
+			std::memcpy(newPtr, ptr, std::min(nsize, osize));
+			::operator delete(ptr);
+		}
 
-		allocStats[STAT_NBE] -= osize;
+		allocStats[STAT_NAE] += 1 * (nsize > 0);
 		allocStats[STAT_NBE] += nsize;
-
-		auto t0 = spring_now();
-		std::memcpy(newPtr, ptr, std::min(nsize, osize));
-		std::memset(ptr, 0, osize);
-		::operator delete(ptr);
 		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-
 		return newPtr;
 	}
 
-	auto t0 = spring_now();
-	auto* ret = luaMemPoolImpl->reAllocMem(ptr, nsize);
-	if (nsize > NUM_BUCKETS * BUCKET_STEP) {
-		allocStats[STAT_NAE] += 1 * (nsize > 0);
-		allocStats[STAT_NBE] += nsize;
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-	}
-	else if (luaMemPoolImpl->isAllocInternal(ret)) {
-		allocStats[STAT_NAI] += 1 * (nsize > 0);
-		allocStats[STAT_NBI] += nsize;
-		allocStats[STAT_NTI] += (spring_now() - t0).toMicroSecsi();
-	}
-	else {
-		allocStats[STAT_NAF] += 1 * (nsize > 0);
-		allocStats[STAT_NBF] += nsize;
-		allocStats[STAT_NTF] += (spring_now() - t0).toMicroSecsi();
-	}
-	return ret;
+	const auto t0 = spring_now();
+	void* newPtr = luaMemPoolImpl->reAllocMem(ptr, osize, nsize);
+	const auto t1 = spring_now();
+
+	const size_t statIdx = luaMemPoolImpl->isAllocInternal(nsize)? 0: 1;
+
+	allocStats[STAT_NAI + statIdx] += 1 * (nsize > 0);
+	allocStats[STAT_NBI + statIdx] += nsize;
+	allocStats[STAT_NTI + statIdx] += (t1 - t0).toMicroSecsi();
+	allocStats[STAT_NBS] = std::max(allocStats[STAT_NBS], uint64_t(luaMemPoolImpl->slab_size()));
+
+	#if (LMP_RECORD_ALLOC_TRACE == 1)
+	allocTrace.push_back({uint64_t(ptr), uint64_t(newPtr), uint32_t(osize), uint32_t(nsize)});
+	#endif
+
+	return newPtr;
 }
 
 void LuaMemPool::Free(void* ptr, size_t size)
@@ -181,33 +158,46 @@ void LuaMemPool::Free(void* ptr, size_t size)
 		return;
 	}
 
-	luaMemPoolImpl->freeMem(ptr);
+	#if (LMP_RECORD_ALLOC_TRACE == 1)
+	if (ptr != nullptr)
+		allocTrace.push_back({uint64_t(ptr), 0, uint32_t(size), 0});
+	#endif
+
+	luaMemPoolImpl->freeMem(ptr, size);
 }
 
 void LuaMemPool::LogStats(const char* handle, const char* lctype)
 {
 	static constexpr auto one = uint64_t(1);
-	const float intPerc = 100.0f * static_cast<float>(allocStats[STAT_NAI]) / static_cast<float>(std::max(allocStats[STAT_NAI] + allocStats[STAT_NAF] + allocStats[STAT_NAE], one));
+	const float intPerc = 100.0f * static_cast<float>(allocStats[STAT_NAI]) / static_cast<float>(std::max(allocStats[STAT_NAI] + allocStats[STAT_NAE], one));
 	const float avgAllocTimeI = static_cast<float>(allocStats[STAT_NTI]) / static_cast<float>(std::max(allocStats[STAT_NAI], one));
-	const float avgAllocTimeF = static_cast<float>(allocStats[STAT_NTF]) / static_cast<float>(std::max(allocStats[STAT_NAF], one));
 	const float avgAllocTimeE = static_cast<float>(allocStats[STAT_NTE]) / static_cast<float>(std::max(allocStats[STAT_NAE], one));
 	std::string msg = fmt::sprintf(
-		"[LuaMemPool::%s][handle=%s (%s)] index=%u numAllocs{int+, int-, ext, int_p}={%u, %u, %u, %.1f} allocedSize{int+, int-, ext}={%u, %u, %u}, avgAllocTime{int+, int-, ext}={%.4f, %.4f, %.4f}",
+		"[LuaMemPool::%s][handle=%s (%s)] index=%u numAllocs{int, ext, int_p}={%u, %u, %.1f} allocedSize{int, ext}={%u, %u}, avgAllocTime{int, ext}={%.4f, %.4f} slabSize{peak, cur}={%uKB, %uKB} fragmentation=%.1f%%",
 		__func__,
 		handle,
 		lctype,
 		globalIndex,
 		allocStats[STAT_NAI],
-		allocStats[STAT_NAF],
 		allocStats[STAT_NAE],
 		intPerc,
 		allocStats[STAT_NBI],
-		allocStats[STAT_NBF],
 		allocStats[STAT_NBE],
 		avgAllocTimeI,
-		avgAllocTimeF,
-		avgAllocTimeE
+		avgAllocTimeE,
+		allocStats[STAT_NBS] / 1024,
+		GetSlabSize() / 1024,
+		GetFragmentation() * 100.0f
 	);
 	LOG("%s", msg.c_str());
 	allocStats = {};
+
+	#if (LMP_RECORD_ALLOC_TRACE == 1)
+	if (FILE* f = fopen(fmt::sprintf("LuaMemPool-%s.trace", handle).c_str(), "wb"); f != nullptr) {
+		fwrite(allocTrace.data(), sizeof(TraceRecord), allocTrace.size(), f);
+		fclose(f);
+	}
+
+	allocTrace.clear();
+	#endif
 }
@@ -11,6 +11,8 @@
 #include "System/UnorderedMap.hpp"
 
 #define LMP_USE_CHUNK_TABLE 0
+// dump every (re)allocation to LuaMemPool-<handle>.trace, see benchmarkLuaMemPool
+#define LMP_RECORD_ALLOC_TRACE 0
 
 class CLuaHandle;
 class LuaMemPool {
@@ -33,6 +35,14 @@ public:
 	LuaMemPool& operator = (const LuaMemPool& p) = delete;
 	LuaMemPool& operator = (LuaMemPool&& p) = delete;
 
+public:
+	struct TraceRecord {
+		uint64_t optr; // 0 for allocations
+		uint64_t nptr; // 0 for deallocations
+		uint32_t osize;
+		uint32_t nsize;
+	};
+
 public:
 	static size_t GetPoolCount();
 
@@ -56,27 +66,33 @@ public:
 	size_t  GetSharedCount() const { return sharedCount; }
 	size_t& GetSharedCount()       { return sharedCount; }
 
+	size_t GetSlabSize() const { return ((luaMemPoolImpl != nullptr)? luaMemPoolImpl->slab_size(): 0); }
+	size_t GetUsedSize() const { return ((luaMemPoolImpl != nullptr)? luaMemPoolImpl->used_size(): 0); }
+	float GetFragmentation() const { return ((luaMemPoolImpl != nullptr)? luaMemPoolImpl->fragmentation(): 0.0f); }
+
 public:
 	static bool enabled;
 private:
 	static constexpr uint32_t NUM_BUCKETS = 32;
 	static constexpr uint32_t BUCKET_STEP = 16;
-	using LuaMemPoolImpl = PassThroughPool<NUM_BUCKETS, 4 * (1024 * 1024)>;
+	using LuaMemPoolImpl = SlabPool<NUM_BUCKETS, BUCKET_STEP, 64 * 1024>;
 	std::unique_ptr<LuaMemPoolImpl> luaMemPoolImpl;
 
 	enum {
 		STAT_NAI = 0, // number of internal allocs
-		STAT_NAF = 1, // number of int fail allocs
-		STAT_NAE = 2, // number of external allocs
-		STAT_NBI = 3, // number of bytes alloced (internal)
-		STAT_NBF = 4, // number of bytes alloced (int fail)
-		STAT_NBE = 5, // number of bytes alloced (external)
-		STAT_NTI = 6, // cumulative time spent on internal allocs
-		STAT_NTF = 7, // cumulative time spent on int fail allocs
-		STAT_NTE = 8, // cumulative time spent on external allocs
+		STAT_NAE = 1, // number of external allocs
+		STAT_NBI = 2, // number of bytes alloced (internal)
+		STAT_NBE = 3, // number of bytes alloced (external)
+		STAT_NTI = 4, // cumulative time spent on internal allocs
+		STAT_NTE = 5, // cumulative time spent on external allocs
+		STAT_NBS = 6, // peak number of bytes reserved by slabs
 	};
 
-	std::array<uint64_t, 9> allocStats = { 0, 0, 0, 0, 0 };
+	std::array<uint64_t, 7> allocStats = {};
+
+	#if (LMP_RECORD_ALLOC_TRACE == 1)
+	std::vector<TraceRecord> allocTrace;
+	#endif
 
 	size_t globalIndex = 0;
 	size_t sharedCount = 0;
@@ -12,6 +12,7 @@
 #include "System/float4.h"
 #include "LuaInclude.h"
 
+#include "LuaBytecodeCache.h"
 #include "LuaConstGame.h"
 #include "LuaConstEngine.h"
 #include "LuaIO.h"
@@ -237,7 +238,7 @@ bool LuaParser::Execute()
 	int errorNum = 0;
 
 	tracy::LuaRemove(code.data());
-	if ((errorNum = luaL_loadbuffer(L, code.c_str(), code.size(), codeLabel.c_str())) != 0) {
+	if ((errorNum = LuaBytecodeCache::LoadBuffer(L, code, codeLabel)) != 0) {
 		SNPRINTF(errorBuf, sizeof(errorBuf), "[loadbuf] error %d (\"%s\") in %s", errorNum, lua_tostring(L, -1), codeLabel.c_str());
 		LUA_CLOSE(&L);
 
@@ -644,7 +645,7 @@ int LuaParser::Include(lua_State* L)
 	}
 
 	tracy::LuaRemove(code.data());
-	int error = luaL_loadbuffer(L, code.c_str(), code.size(), filename.c_str());
+	int error = LuaBytecodeCache::LoadBuffer(L, code, filename);
 	if (error != 0) {
 		char buf[1024];
 		SNPRINTF(buf, sizeof(buf), "error = %i, %s, %s\n", error, filename.c_str(), lua_tostring(L, -1));
@@ -748,6 +749,99 @@ int LuaParser::DontMessWithMyCase(lua_State* L)
 //  LuaTable
 //
 
+struct LuaTable::SnapshotData {
+	// the result of every conversion the getters can apply, so
+	// reading a snapshot never needs the lua_State it came from
+	struct Value {
+		int type = LUA_TNIL;
+
+		bool isNumber = false; // includes numeric strings
+		bool isString = false; // includes numbers
+		bool hasBool = false;
+		bool hasFloat3 = false;
+		bool hasFloat4 = false;
+		bool boolValue = false;
+
+		int intValue = 0;
+		int length = 0;
+		float number = 0.0f;
+
+		float4 vector;
+		std::string string;
+
+		std::shared_ptr<const SnapshotData> table;
+	};
+
+	const Value* Find(const std::string& key) const {
+		const auto iter = std::lower_bound(strValues.begin(), strValues.end(), key, [](const std::pair<std::string, Value>& p, const std::string& k) { return (p.first < k); });
+
+		if (iter == strValues.end() || iter->first != key)
+			return nullptr;
+
+		return &iter->second;
+	}
+	const Value* Find(int key) const {
+		const auto iter = std::lower_bound(intValues.begin(), intValues.end(), key, [](const std::pair<int, Value>& p, int k) { return (p.first < k); });
+
+		if (iter == intValues.end() || iter->first != key)
+			return nullptr;
+
+		return &iter->second;
+	}
+
+	const Value* Lookup(const std::string& mixedKey) const;
+
+	// both sorted by key
+	std::vector<std::pair<std::string, Value>> strValues;
+	std::vector<std::pair<int, Value>> intValues;
+
+	int length = 0;
+	bool lowerCppKeys = false;
+};
+
+
+// same key resolution as LuaTable::PushValue(const std::string&)
+const LuaTable::SnapshotData::Value* LuaTable::SnapshotData::Lookup(const std::string& mixedKey) const
+{
+	const std::string key = !lowerCppKeys ? mixedKey : StringToLower(mixedKey);
+
+	if (key.find('.') == std::string::npos)
+		return Find(key);
+
+	// nested key (e.g. "subtable.subsub.mahkey")
+	const SnapshotData* data = this;
+
+	size_t lastpos = 0;
+	size_t dotpos = key.find('.');
+
+	do {
+		const Value* value = data->Find(key.substr(lastpos, dotpos));
+
+		if (value == nullptr || value->table == nullptr)
+			return nullptr;
+
+		data = value->table.get();
+		lastpos = dotpos + 1;
+		dotpos = key.find('.', lastpos);
+	} while (dotpos != std::string::npos);
+
+	const std::string keyname = key.substr(lastpos);
+	const Value* value = data->Find(keyname);
+
+	// try as string, then as integer
+	if (value != nullptr)
+		return value;
+
+	bool failed;
+	const int i = StringToInt(keyname, &failed);
+
+	if (failed)
+		return nullptr;
+
+	return data->Find(i);
+}
+
+
 LuaTable::LuaTable()
 : path(""),
   isValid(false),
@@ -782,9 +876,16 @@ LuaTable::LuaTable(LuaParser* _parser)
 
 LuaTable::LuaTable(const LuaTable& tbl)
 {
-	parser = tbl.parser;
-	L      = tbl.L;
-	path   = tbl.path;
+	parser   = tbl.parser;
+	L        = tbl.L;
+	path     = tbl.path;
+	snapshot = tbl.snapshot;
+
+	if (snapshot != nullptr) {
+		refnum  = LUA_NOREF;
+		isValid = true;
+		return;
+	}
 
 	if (parser != nullptr)
 		parser->AddTable(this);
@@ -819,8 +920,15 @@ LuaTable& LuaTable::operator=(const LuaTable& tbl)
 		parser = tbl.parser;
 	}
 
-	L    = tbl.L;
-	path = tbl.path;
+	L        = tbl.L;
+	path     = tbl.path;
+	snapshot = tbl.snapshot;
+
+	if (snapshot != nullptr) {
+		refnum  = LUA_NOREF;
+		isValid = true;
+		return *this;
+	}
 
 	if (tbl.PushTable()) {
 		lua_pushvalue(L, -1); // copy
@@ -842,6 +950,17 @@ LuaTable LuaTable::SubTable(int key) const
 	SNPRINTF(buf, 32, "[%i]", key);
 	subTable.path = path + buf;
 
+	if (snapshot != nullptr) {
+		const SnapshotData::Value* value = snapshot->Find(key);
+
+		if (value != nullptr && value->table != nullptr) {
+			subTable.snapshot = value->table;
+			subTable.isValid = true;
+		}
+
+		return subTable;
+	}
+
 	if (!PushTable())
 		return subTable;
 
@@ -864,11 +983,23 @@ LuaTable LuaTable::SubTable(int key) const
 
 LuaTable LuaTable::SubTable(const std::string& mixedKey) const
 {
-	const std::string key = !((parser != nullptr)? parser->lowerCppKeys : true) ? mixedKey : StringToLower(mixedKey);
+	const bool lowerCppKeys = (snapshot != nullptr)? snapshot->lowerCppKeys: ((parser != nullptr)? parser->lowerCppKeys : true);
+	const std::string key = !lowerCppKeys ? mixedKey : StringToLower(mixedKey);
 
 	LuaTable subTable;
 	subTable.path = path + "." + key;
 
+	if (snapshot != nullptr) {
+		const SnapshotData::Value* value = snapshot->Find(key);
+
+		if (value != nullptr && value->table != nullptr) {
+			subTable.snapshot = value->table;
+			subTable.isValid = true;
+		}
+
+		return subTable;
+	}
+
 	if (!PushTable())
 		return subTable;
 
@@ -947,7 +1078,7 @@ LuaTable::~LuaTable()
 
 bool LuaTable::PushTable() const
 {
-	if (!isValid)
+	if (!isValid || snapshot != nullptr)
 		return false;
 
 	if ((refnum != LUA_NOREF) && (parser->currentRef == refnum)) {
@@ -1080,6 +1211,9 @@ bool LuaTable::PushValue(const std::string& mixedKey) const
 
 bool LuaTable::KeyExists(int key) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Find(key) != nullptr);
+
 	if (!PushValue(key))
 		return false;
 
@@ -1090,6 +1224,9 @@ bool LuaTable::KeyExists(int key) const
 
 bool LuaTable::KeyExists(const std::string& key) const
 {
+	if (snapshot != nullptr)
+		return (snapshot->Lookup(key) != nullptr);
+
 	if (!PushValue(key))
 		return false;
 
@@ -1104,39 +1241,49 @@ bool LuaTable::KeyExists(const std::string& key) const
 //  Value types
 //
 
+static LuaTable::DataType GetDataType(int type)
+{
+	switch (type) {
+		case LUA_TBOOLEAN: return LuaTable::BOOLEAN;
+		case LUA_TNUMBER:  return LuaTable::NUMBER;
+		case LUA_TSTRING:  return LuaTable::STRING;
+		case LUA_TTABLE:   return LuaTable::TABLE;
+		default:           return LuaTable::NIL;
+	}
+}
+
+
 LuaTable::DataType LuaTable::GetType(int key) const
 {
+	if (snapshot != nullptr) {
+		const SnapshotData::Value* value = snapshot->Find(key);
+		return ((value != nullptr)? GetDataType(value->type): NIL);
+	}
+
 	if (!PushValue(key))
 		return NIL;
 
 	const int type = lua_type(L, -1);
 	lua_pop(L, 1);
 
-	switch (type) {
-		case LUA_TBOOLEAN: return BOOLEAN;
-		case LUA_TNUMBER:  return NUMBER;
-		case LUA_TSTRING:  return STRING;
-		case LUA_TTABLE:   return TABLE;
-		default:           return NIL;
-	}
+	return GetDataType(type);
 }
 
 
 LuaTable::DataType LuaTable::GetType(const std::string& key) const
 {
+	if (snapshot != nullptr) {
+		const SnapshotData::Value* value = snapshot->Lookup(key);
+		return ((value != nullptr)? GetDataType(value->type): NIL);
+	}
+
 	if (!PushValue(key))
 		return NIL;
 
 	const int type = lua_type(L, -1);
 	lua_pop(L, 1);
 
-	switch (type) {
-		case LUA_TBOOLEAN: return BOOLEAN;
-		case LUA_TNUMBER:  return NUMBER;
-		case LUA_TSTRING:  return STRING;
-		case LUA_TTABLE:   return TABLE;
-		default:           return NIL;
-	}
+	return GetDataType(type);
 }
 
 
@@ -1148,6 +1295,9 @@ LuaTable::DataType LuaTable::GetType(const std::string& key) const
 
 int LuaTable::GetLength() const
 {
+	if (snapshot != nullptr)
+		return snapshot->length;
+
 	if (!PushTable())
 		return 0;
 
@@ -1157,6 +1307,11 @@ int LuaTable::GetLength() const
 
 int LuaTable::GetLength(int key) const
 {
+	if (snapshot != nullptr) {
+		const SnapshotData::Value* value = snapshot->Find(key);
+		return ((value != nullptr)? value->length: 0);
+	}
+
 	if (!PushValue(key))
 		return 0;
 
@@ -1168,6 +1323,11 @@ int LuaTable::GetLength(int key) const
 
 int LuaTable::GetLength(const std::string& key) const
 {
+	if (snapshot != nullptr) {
+		const SnapshotData::Value* value = snapshot->Lookup(key);
+		return ((value != nullptr)? value->length: 0);
+	}
+
 	if (!PushValue(key))
 		return 0;
 
@@ -1185,6 +1345,15 @@ int LuaTable::GetLength(const std::string& key) const
 
 bool LuaTable::GetKeys(std::vector<int>& data) const
 {
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->intValues) {
+			data.push_back(pair.first);
+		}
+
+		std::stable_sort(data.begin(), data.end());
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1202,6 +1371,15 @@ bool LuaTable::GetKeys(std::vector<int>& data) const
 
 bool LuaTable::GetKeys(std::vector<std::string>& data) const
 {
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->strValues) {
+			data.push_back(pair.first);
+		}
+
+		std::stable_sort(data.begin(), data.end());
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1220,6 +1398,19 @@ bool LuaTable::GetKeys(std::vector<std::string>& data) const
 
 bool LuaTable::GetPairs(std::vector<std::pair<int, std::string>>& data) const
 {
+	using T = std::remove_reference<decltype(data)>::type;
+	using P = T::value_type;
+
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->intValues) {
+			if (pair.second.isString)
+				data.emplace_back(pair.first, pair.second.string);
+		}
+
+		std::stable_sort(data.begin(), data.end(), [](const P& a, const P& b) { return (a.first < b.first); });
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1239,15 +1430,25 @@ bool LuaTable::GetPairs(std::vector<std::pair<int, std::string>>& data) const
 		}
 	}
 
-	using T = std::remove_reference<decltype(data)>::type;
-	using P = T::value_type;
-
 	std::stable_sort(data.begin(), data.end(), [](const P& a, const P& b) { return (a.first < b.first); });
 	return true;
 }
 
 bool LuaTable::GetPairs(std::vector<std::pair<std::string, float>>& data) const
 {
+	using T = std::remove_reference<decltype(data)>::type;
+	using P = T::value_type;
+
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->strValues) {
+			if (pair.second.isNumber)
+				data.emplace_back(pair.first, pair.second.number);
+		}
+
+		std::stable_sort(data.begin(), data.end(), [](const P& a, const P& b) { return (a.first < b.first); });
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1260,15 +1461,31 @@ bool LuaTable::GetPairs(std::vector<std::pair<std::string, float>>& data) const
 		data.emplace_back(lua_tostring(L, -2), lua_tonumber(L, -1));
 	}
 
-	using T = std::remove_reference<decltype(data)>::type;
-	using P = T::value_type;
-
 	std::stable_sort(data.begin(), data.end(), [](const P& a, const P& b) { return (a.first < b.first); });
 	return true;
 }
 
 bool LuaTable::GetPairs(std::vector<std::pair<std::string, std::string>>& data) const
 {
+	using T = std::remove_reference<decltype(data)>::type;
+	using P = T::value_type;
+
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->strValues) {
+			if (pair.second.isString) { // includes numbers
+				data.emplace_back(pair.first, pair.second.string);
+				continue;
+			}
+			if (pair.second.type == LUA_TBOOLEAN) {
+				data.emplace_back(pair.first, pair.second.boolValue ? "1" : "0");
+				continue;
+			}
+		}
+
+		std::stable_sort(data.begin(), data.end(), [](const P& a, const P& b) { return (a.first < b.first); });
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1288,9 +1505,6 @@ bool LuaTable::GetPairs(std::vector<std::pair<std::string, std::string>>& data)
 		}
 	}
 
-	using T = std::remove_reference<decltype(data)>::type;
-	using P = T::value_type;
-
 	std::stable_sort(data.begin(), data.end(), [](const P& a, const P& b) { return (a.first < b.first); });
 	return true;
 }
@@ -1304,6 +1518,15 @@ bool LuaTable::GetPairs(std::vector<std::pair<std::string, std::string>>& data)
 
 bool LuaTable::GetMap(spring::unordered_map<int, float>& data) const
 {
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->intValues) {
+			if (pair.second.isNumber)
+				data[pair.first] = pair.second.number;
+		}
+
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1321,6 +1544,15 @@ bool LuaTable::GetMap(spring::unordered_map<int, float>& data) const
 
 bool LuaTable::GetMap(spring::unordered_map<int, std::string>& data) const
 {
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->intValues) {
+			if (pair.second.isString)
+				data[pair.first] = pair.second.string;
+		}
+
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1345,6 +1577,15 @@ bool LuaTable::GetMap(spring::unordered_map<int, std::string>& data) const
 
 bool LuaTable::GetMap(spring::unordered_map<std::string, float>& data) const
 {
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->strValues) {
+			if (pair.second.isNumber)
+				data[pair.first] = pair.second.number;
+		}
+
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1362,6 +1603,21 @@ bool LuaTable::GetMap(spring::unordered_map<std::string, float>& data) const
 
 bool LuaTable::GetMap(spring::unordered_map<std::string, std::string>& data) const
 {
+	if (snapshot != nullptr) {
+		for (const auto& pair: snapshot->strValues) {
+			if (pair.second.isString) { // includes numbers
+				data[pair.first] = pair.second.string;
+				continue;
+			}
+			if (pair.second.type == LUA_TBOOLEAN) {
+				data[pair.first] = pair.second.boolValue ? "1" : "0";
+				continue;
+			}
+		}
+
+		return true;
+	}
+
 	if (!PushTable())
 		return false;
 
@@ -1470,6 +1726,55 @@ static bool ParseBoolean(lua_State* L, int index, bool& value)
 }
 
 
+static int GetSnapshotValue(const LuaTable::SnapshotData::Value* value, int def)
+{
+	if (value == nullptr || (value->intValue == 0 && !value->isNumber && !value->isString))
+		return def;
+
+	return value->intValue;
+}
+
+static bool GetSnapshotValue(const LuaTable::SnapshotData::Value* value, bool def)
+{
+	if (value == nullptr || !value->hasBool)
+		return def;
+
+	return value->boolValue;
+}
+
+static float GetSnapshotValue(const LuaTable::SnapshotData::Value* value, float def)
+{
+	if (value == nullptr || (value->number == 0.0f && !value->isNumber && !value->isString))
+		return def;
+
+	return value->number;
+}
+
+static float3 GetSnapshotValue(const LuaTable::SnapshotData::Value* value, const float3& def)
+{
+	if (value == nullptr || !value->hasFloat3)
+		return def;
+
+	return value->vector;
+}
+
+static float4 GetSnapshotValue(const LuaTable::SnapshotData::Value* value, const float4& def)
+{
+	if (value == nullptr || !value->hasFloat4)
+		return def;
+
+	return value->vector;
+}
+
+static std::string GetSnapshotValue(const LuaTable::SnapshotData::Value* value, const std::string& def)
+{
+	if (value == nullptr || !value->isString)
+		return def;
+
+	return value->string;
+}
+
+
 /******************************************************************************/
 /******************************************************************************/
 //
@@ -1478,6 +1783,9 @@ static bool ParseBoolean(lua_State* L, int index, bool& value)
 
 int LuaTable::Get(const std::string& key, int def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Lookup(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1493,6 +1801,9 @@ int LuaTable::Get(const std::string& key, int def) const
 
 bool LuaTable::Get(const std::string& key, bool def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Lookup(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1508,6 +1819,9 @@ bool LuaTable::Get(const std::string& key, bool def) const
 
 float LuaTable::Get(const std::string& key, float def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Lookup(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1524,6 +1838,9 @@ float LuaTable::Get(const std::string& key, float def) const
 
 float3 LuaTable::Get(const std::string& key, const float3& def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Lookup(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1538,6 +1855,9 @@ float3 LuaTable::Get(const std::string& key, const float3& def) const
 
 float4 LuaTable::Get(const std::string& key, const float4& def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Lookup(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1554,6 +1874,9 @@ float4 LuaTable::Get(const std::string& key, const float4& def) const
 
 std::string LuaTable::Get(const std::string& key, const std::string& def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Lookup(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1575,6 +1898,9 @@ std::string LuaTable::Get(const std::string& key, const std::string& def) const
 
 int LuaTable::Get(int key, int def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Find(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1590,6 +1916,9 @@ int LuaTable::Get(int key, int def) const
 
 bool LuaTable::Get(int key, bool def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Find(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1605,6 +1934,9 @@ bool LuaTable::Get(int key, bool def) const
 
 float LuaTable::Get(int key, float def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Find(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1621,6 +1953,9 @@ float LuaTable::Get(int key, float def) const
 
 float3 LuaTable::Get(int key, const float3& def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Find(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1635,6 +1970,9 @@ float3 LuaTable::Get(int key, const float3& def) const
 
 float4 LuaTable::Get(int key, const float4& def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Find(key), def);
+
 	if (!PushValue(key)) {
 		return def;
 	}
@@ -1651,6 +1989,9 @@ float4 LuaTable::Get(int key, const float4& def) const
 
 std::string LuaTable::Get(int key, const std::string& def) const
 {
+	if (snapshot != nullptr)
+		return GetSnapshotValue(snapshot->Find(key), def);
+
 	if (!PushValue(key))
 		return def;
 
@@ -1697,3 +2038,105 @@ float4 LuaTable::GetFloat4(const std::string& key, const float4& def) const
 
 /******************************************************************************/
 /******************************************************************************/
+//
+//  Snapshots
+//
+
+using SnapshotTables = spring::unordered_map<const void*, std::shared_ptr<const LuaTable::SnapshotData>>;
+
+static std::shared_ptr<const LuaTable::SnapshotData> MakeSnapshotData(lua_State* L, int table, bool lowerCppKeys, SnapshotTables& tables);
+
+static void MakeSnapshotValue(lua_State* L, LuaTable::SnapshotData::Value& value, bool lowerCppKeys, SnapshotTables& tables)
+{
+	// work on a copy, lua_tostring and lua_objlen turn numbers into strings
+	// in place which would break the caller's lua_next
+	lua_pushvalue(L, -1);
+
+	value.type     = lua_type(L, -1);
+	value.isNumber = lua_isnumber(L, -1);
+	value.isString = lua_isstring(L, -1);
+	value.intValue = lua_toint(L, -1);
+	value.number   = lua_tonumber(L, -1);
+	value.hasBool  = ParseBoolean(L, -1, value.boolValue);
+
+	float3 vec3;
+	float4 vec4;
+
+	// a successful float4 parse implies a float3 parse with the same xyz
+	if ((value.hasFloat4 = ParseFloat4(L, -1, vec4))) {
+		value.hasFloat3 = true;
+		value.vector = vec4;
+	} else if ((value.hasFloat3 = ParseFloat3(L, -1, vec3))) {
+		value.vector = vec3;
+	}
+
+	if (value.isString)
+		value.string = lua_tostring(L, -1);
+
+	value.length = lua_objlen(L, -1);
+
+	if (value.type == LUA_TTABLE)
+		value.table = MakeSnapshotData(L, lua_gettop(L), lowerCppKeys, tables);
+
+	lua_pop(L, 1);
+}
+
+static std::shared_ptr<const LuaTable::SnapshotData> MakeSnapshotData(lua_State* L, int table, bool lowerCppKeys, SnapshotTables& tables)
+{
+	using Value = LuaTable::SnapshotData::Value;
+
+	const void* tablePtr = lua_topointer(L, table);
+	const auto iter = tables.find(tablePtr);
+
+	// tables referenced more than once are shared; one that refers back to
+	// itself is still null at this point and is cut off like a non-table
+	if (iter != tables.end())
+		return iter->second;
+
+	tables[tablePtr] = nullptr;
+
+	std::shared_ptr<LuaTable::SnapshotData> data = std::make_shared<LuaTable::SnapshotData>();
+
+	data->length = lua_objlen(L, table);
+	data->lowerCppKeys = lowerCppKeys;
+
+	if (!lua_checkstack(L, 4))
+		return data;
+
+	for (lua_pushnil(L); lua_next(L, table) != 0; lua_pop(L, 1)) {
+		if (lua_israwstring(L, -2)) {
+			data->strValues.emplace_back(lua_tostring(L, -2), Value{});
+			MakeSnapshotValue(L, data->strValues.back().second, lowerCppKeys, tables);
+			continue;
+		}
+
+		// fractional keys can not be reached through PushValue(int) either
+		if (!lua_israwnumber(L, -2) || lua_tonumber(L, -2) != lua_toint(L, -2))
+			continue;
+
+		data->intValues.emplace_back(lua_toint(L, -2), Value{});
+		MakeSnapshotValue(L, data->intValues.back().second, lowerCppKeys, tables);
+	}
+
+	std::sort(data->strValues.begin(), data->strValues.end(), [](const std::pair<std::string, Value>& a, const std::pair<std::string, Value>& b) { return (a.first < b.first); });
+	std::sort(data->intValues.begin(), data->intValues.end(), [](const std::pair<int, Value>& a, const std::pair<int, Value>& b) { return (a.first < b.first); });
+
+	return (tables[tablePtr] = data);
+}
+
+
+LuaTable LuaTable::Snapshot() const
+{
+	LuaTable tbl;
+	tbl.path = path;
+
+	if (snapshot != nullptr) {
+		tbl.snapshot = snapshot;
+	} else if (PushTable()) {
+		SnapshotTables tables;
+		tbl.snapshot = MakeSnapshotData(L, lua_gettop(L), parser->lowerCppKeys, tables);
+	}
+
+	tbl.isValid = (tbl.snapshot != nullptr);
+	return tbl;
+}
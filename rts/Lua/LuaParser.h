@@ -3,6 +3,7 @@
 #ifndef LUA_PARSER_H
 #define LUA_PARSER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -23,6 +24,9 @@ struct lua_State;
 class LuaTable {
 friend class LuaParser;
 
+public:
+	struct SnapshotData;
+
 public:
 	LuaTable();
 	LuaTable(const LuaTable& tbl);
@@ -33,7 +37,16 @@ public:
 	LuaTable SubTable(const std::string& key) const;
 	LuaTable SubTableExpr(const std::string& expr) const;
 
-	bool IsValid() const { return (parser != nullptr); }
+	/**
+	 * Deep copy of this table (and all tables below it) which no longer
+	 * refers to the parser; getters on it return exactly what they would
+	 * on the original, but are safe to call from any thread. Only keys
+	 * that are strings or integral numbers are copied, and metatables are
+	 * not consulted.
+	 */
+	LuaTable Snapshot() const;
+
+	bool IsValid() const { return (parser != nullptr || snapshot != nullptr); }
 
 	const std::string& GetPath() const { return path; }
 
@@ -112,6 +125,8 @@ private:
 	LuaParser* parser;
 	lua_State* L;
 	int refnum;
+
+	std::shared_ptr<const SnapshotData> snapshot;
 };
 
 
@@ -0,0 +1,314 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <fstream>
+
+#include "LuaProfiler.h"
+#include "LuaHandle.h"
+#include "LuaInclude.h"
+#include "LuaIO.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Platform/Threading.h"
+
+
+CLuaProfiler& CLuaProfiler::GetInstance()
+{
+	static CLuaProfiler instance;
+	return instance;
+}
+
+
+void CLuaProfiler::Enable()
+{
+	enabled = true;
+}
+
+void CLuaProfiler::Disable()
+{
+	enabled = false;
+
+	for (auto& pair: states) {
+		lua_sethook(pair.second.L, nullptr, 0, 0);
+	}
+
+	states.clear();
+}
+
+void CLuaProfiler::Clear()
+{
+	nodes.clear();
+	names.clear();
+
+	nodeIndices.clear();
+	nameIndices.clear();
+	functionNames.clear();
+
+	// open frames refer to nodes that are gone now
+	for (auto& pair: states) {
+		pair.second.frames.clear();
+		pair.second.callInDepth = 0;
+	}
+}
+
+
+void CLuaProfiler::RemoveState(const luaContextData* lcd)
+{
+	states.erase(lcd);
+}
+
+
+void CLuaProfiler::EnterCallInImpl(const CLuaHandle* handle, lua_State* L, const char* callIn)
+{
+	// LuaIntro can run on the loading thread
+	if (!Threading::IsMainThread())
+		return;
+
+	const luaContextData* lcd = GetLuaContextData(L);
+	const auto pair = states.emplace(lcd, StateData{L, 0, {}});
+
+	StateData& state = pair.first->second;
+
+	if (pair.second)
+		lua_sethook(L, Hook, LUA_MASKCALL | LUA_MASKRET, 0);
+
+	// call-ins triggered from Lua are nested under the calling function
+	const int parent = state.frames.empty()? GetNode(-1, GetName(handle->GetName())): state.frames.back().node;
+
+	state.callInDepth += 1;
+
+	PushFrame(state, lcd, GetNode(parent, GetName(callIn)), true);
+}
+
+void CLuaProfiler::LeaveCallInImpl(lua_State* L)
+{
+	const luaContextData* lcd = GetLuaContextData(L);
+	const auto iter = states.find(lcd);
+
+	if (iter == states.end())
+		return;
+
+	StateData& state = iter->second;
+
+	if (state.callInDepth == 0)
+		return;
+
+	// frames left open by errors or yields are closed along with the call-in
+	while (!state.frames.empty() && state.frames.back().callInDepth >= state.callInDepth) {
+		PopFrame(state, lcd);
+	}
+
+	state.callInDepth -= 1;
+}
+
+
+void CLuaProfiler::Hook(lua_State* L, lua_Debug* ar)
+{
+	CLuaProfiler& profiler = GetInstance();
+
+	if (!profiler.enabled) {
+		// coroutines inherit the hook, these are not reached by Disable
+		lua_sethook(L, nullptr, 0, 0);
+		return;
+	}
+
+	const luaContextData* lcd = GetLuaContextData(L);
+	const auto iter = profiler.states.find(lcd);
+
+	if (iter == profiler.states.end())
+		return;
+
+	StateData& state = iter->second;
+
+	if (state.frames.empty())
+		return;
+
+	switch (ar->event) {
+		case LUA_HOOKCALL: {
+			const int parent = state.frames.back().node;
+			const int name = profiler.GetFunctionName(L, ar);
+
+			profiler.PushFrame(state, lcd, profiler.GetNode(parent, name), false);
+		} break;
+		case LUA_HOOKRET:
+		case LUA_HOOKTAILRET: {
+			// the call-in frame itself is closed by LeaveCallIn
+			if (!state.frames.back().isCallIn)
+				profiler.PopFrame(state, lcd);
+		} break;
+		default: {
+		} break;
+	}
+}
+
+
+void CLuaProfiler::PushFrame(StateData& state, const luaContextData* lcd, int node, bool isCallIn)
+{
+	nodes[node].numCalls += 1;
+
+	state.frames.push_back({node, state.callInDepth, isCallIn, spring_gettime().toNanoSecsi(), 0, lcd->allocState.numLuaAllocs.load(), 0});
+}
+
+void CLuaProfiler::PopFrame(StateData& state, const luaContextData* lcd)
+{
+	const Frame frame = state.frames.back();
+
+	const int64_t time = spring_gettime().toNanoSecsi() - frame.startTime;
+	const uint64_t allocs = lcd->allocState.numLuaAllocs.load() - frame.startAllocs;
+
+	nodes[frame.node].selfTime += std::max(time - frame.childTime, int64_t(0));
+	nodes[frame.node].selfAllocs += (allocs - std::min(allocs, frame.childAllocs));
+
+	state.frames.pop_back();
+
+	if (state.frames.empty())
+		return;
+
+	state.frames.back().childTime += time;
+	state.frames.back().childAllocs += allocs;
+}
+
+
+int CLuaProfiler::GetNode(int parent, int name)
+{
+	const uint64_t key = (uint64_t(uint32_t(parent)) << 32) | uint32_t(name);
+	const auto pair = nodeIndices.emplace(key, nodes.size());
+
+	if (pair.second)
+		nodes.push_back({parent, name, 0, 0, 0});
+
+	return pair.first->second;
+}
+
+int CLuaProfiler::GetName(const std::string& name)
+{
+	const auto pair = nameIndices.emplace(name, names.size());
+
+	if (pair.second)
+		names.push_back(name);
+
+	return pair.first->second;
+}
+
+int CLuaProfiler::GetFunctionName(lua_State* L, lua_Debug* ar)
+{
+	lua_getinfo(L, "S", ar);
+
+	uint64_t key = 0;
+
+	if (ar->what[0] == 'C') {
+		// all C functions share one source, tell them apart by closure
+		lua_getinfo(L, "f", ar);
+		key = reinterpret_cast<uintptr_t>(lua_topointer(L, -1));
+		lua_pop(L, 1);
+	} else {
+		key = reinterpret_cast<uintptr_t>(ar->source) * 31 + ar->linedefined;
+	}
+
+	const auto iter = functionNames.find(key);
+
+	if (iter != functionNames.end())
+		return iter->second;
+
+	lua_getinfo(L, "n", ar);
+
+	std::string name = (ar->name != nullptr)? ar->name: ((ar->what[0] == 'm')? "main": "?");
+
+	if (ar->what[0] == 'C') {
+		name += " [C]";
+	} else {
+		name += " (" + std::string(ar->short_src) + ":" + std::to_string(ar->linedefined) + ")";
+	}
+
+	// reserved as path separator by the folded format
+	std::replace(name.begin(), name.end(), ';', ':');
+
+	return (functionNames[key] = GetName(name));
+}
+
+
+std::string CLuaProfiler::GetPath(int node) const
+{
+	std::string path = names[nodes[node].name];
+
+	for (int parent = nodes[node].parent; parent >= 0; parent = nodes[parent].parent) {
+		path = names[nodes[parent].name] + ";" + path;
+	}
+
+	return path;
+}
+
+bool CLuaProfiler::WriteFolded(const std::string& baseName) const
+{
+	// the name can come from Spring.SendCommands, keep it inside the write-dir
+	if (baseName.empty() || !LuaIO::IsSimplePath(baseName)) {
+		LOG_L(L_ERROR, "[LuaProfiler::%s] invalid output name \"%s\"", __func__, baseName.c_str());
+		return false;
+	}
+
+	const std::string timeName = dataDirsAccess.LocateFile(baseName + ".time.folded", FileQueryFlags::WRITE);
+	const std::string allocName = dataDirsAccess.LocateFile(baseName + ".allocs.folded", FileQueryFlags::WRITE);
+
+	std::ofstream timeOut(timeName, std::ios::out | std::ios::trunc);
+	std::ofstream allocOut(allocName, std::ios::out | std::ios::trunc);
+
+	if (timeName.empty() || allocName.empty() || !timeOut.is_open() || !allocOut.is_open()) {
+		LOG_L(L_ERROR, "[LuaProfiler::%s] could not open \"%s\".{time,allocs}.folded", __func__, baseName.c_str());
+		return false;
+	}
+
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const Node& node = nodes[i];
+
+		if (node.selfTime < 1000 && node.selfAllocs == 0)
+			continue;
+
+		const std::string path = GetPath(i);
+
+		if (node.selfTime >= 1000)
+			timeOut << path << " " << (node.selfTime / 1000) << "\n";
+		if (node.selfAllocs > 0)
+			allocOut << path << " " << node.selfAllocs << "\n";
+	}
+
+	LOG("[LuaProfiler::%s] wrote " _STPF_ " call paths to \"%s\".{time,allocs}.folded", __func__, nodes.size(), baseName.c_str());
+	return (timeOut.good() && allocOut.good());
+}
+
+void CLuaProfiler::LogSummary(size_t maxEntries) const
+{
+	struct Entry {
+		int name;
+		uint32_t numCalls;
+		uint64_t selfTime;
+		uint64_t selfAllocs;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<int> entryIndices(names.size(), -1);
+
+	// merge all call paths ending in the same function
+	for (const Node& node: nodes) {
+		if (entryIndices[node.name] < 0) {
+			entryIndices[node.name] = entries.size();
+			entries.push_back({node.name, 0, 0, 0});
+		}
+
+		Entry& e = entries[entryIndices[node.name]];
+
+		e.numCalls += node.numCalls;
+		e.selfTime += node.selfTime;
+		e.selfAllocs += node.selfAllocs;
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return (a.selfTime > b.selfTime); });
+
+	LOG("[LuaProfiler::%s] top " _STPF_ " of " _STPF_ " functions by self time", __func__, std::min(maxEntries, entries.size()), entries.size());
+
+	for (size_t i = 0, n = std::min(maxEntries, entries.size()); i < n; i++) {
+		const Entry& e = entries[i];
+		LOG("\t%9.3fms %8u calls %10u allocs  %s", e.selfTime * 1e-6f, e.numCalls, unsigned(e.selfAllocs), names[e.name].c_str());
+	}
+}
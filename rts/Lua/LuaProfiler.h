@@ -0,0 +1,127 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_PROFILER_H
+#define LUA_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "System/Misc/NonCopyable.h"
+#include "System/Platform/Threading.h"
+#include "System/UnorderedMap.hpp"
+
+struct lua_State;
+struct lua_Debug;
+struct luaContextData;
+class CLuaHandle;
+
+/**
+ * @brief Instrumenting profiler for Lua call-ins
+ *
+ * While enabled, every call-in run through CLuaHandle::RunCallInTraceback on
+ * the main thread installs a call/return debug hook on its state. Time and
+ * allocations are attributed to the full call path (handle, call-in, then
+ * every Lua or C function below it), so the cost of single gadgets and
+ * widgets shows up through the files their functions are defined in.
+ *
+ * Coroutines share the frame stack of their state; since yields fire no
+ * return hooks, time spent in them may be attributed one level off until
+ * the call-in ends and its remaining frames are closed.
+ *
+ * Results are written as folded stacks ("a;b;c <value>" per line), which is
+ * what flamegraph.pl, speedscope and similar tools read.
+ */
+class CLuaProfiler : public spring::noncopyable
+{
+public:
+	static CLuaProfiler& GetInstance();
+
+	bool IsEnabled() const { return enabled; }
+	void Enable();
+	void Disable();
+	void Clear();
+
+	/// writes <baseName>.time.folded (self time in us) and <baseName>.allocs.folded
+	bool WriteFolded(const std::string& baseName) const;
+	void LogSummary(size_t maxEntries) const;
+
+	void EnterCallIn(const CLuaHandle* handle, lua_State* L, const char* callIn) {
+		if (!enabled)
+			return;
+
+		EnterCallInImpl(handle, L, callIn);
+	}
+	void LeaveCallIn(lua_State* L) {
+		// states is only touched by the main thread, see EnterCallInImpl
+		if (!Threading::IsMainThread())
+			return;
+		if (states.empty())
+			return;
+
+		LeaveCallInImpl(L);
+	}
+
+	/// must be called before a profiled state is closed
+	void RemoveState(const luaContextData* lcd);
+
+private:
+	struct Node {
+		int parent;
+		int name;
+
+		uint32_t numCalls;
+
+		uint64_t selfTime; // ns
+		uint64_t selfAllocs;
+	};
+
+	struct Frame {
+		int node;
+		int callInDepth; // number of call-ins this frame is nested in
+		bool isCallIn;
+
+		int64_t startTime;
+		int64_t childTime;
+
+		uint64_t startAllocs;
+		uint64_t childAllocs;
+	};
+
+	struct StateData {
+		lua_State* L;
+		int callInDepth;
+
+		std::vector<Frame> frames;
+	};
+
+	static void Hook(lua_State* L, lua_Debug* ar);
+
+	void EnterCallInImpl(const CLuaHandle* handle, lua_State* L, const char* callIn);
+	void LeaveCallInImpl(lua_State* L);
+
+	void PushFrame(StateData& state, const luaContextData* lcd, int node, bool isCallIn);
+	void PopFrame(StateData& state, const luaContextData* lcd);
+
+	int GetNode(int parent, int name);
+	int GetName(const std::string& name);
+	int GetFunctionName(lua_State* L, lua_Debug* ar);
+
+	std::string GetPath(int node) const;
+
+private:
+	bool enabled = false;
+
+	std::vector<Node> nodes;
+	std::vector<std::string> names;
+
+	// (parent << 32 | name) -> node
+	spring::unordered_map<uint64_t, int> nodeIndices;
+	spring::unordered_map<std::string, int> nameIndices;
+	// closure (C) or source and line (Lua) -> name
+	spring::unordered_map<uint64_t, int> functionNames;
+
+	spring::unordered_map<const luaContextData*, StateData> states;
+};
+
+#endif /* LUA_PROFILER_H */
@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "LuaRulesParams.h"
+#include "System/UnorderedMap.hpp"
 #include "System/creg/STL_Variant.h"
 
 using namespace LuaRulesParams;
@@ -10,3 +11,66 @@ CR_REG_METADATA(Param, (
 	CR_MEMBER(los),
 	CR_MEMBER(value)
 ))
+
+CR_BIND(Params::Entry,)
+CR_REG_METADATA_SUB(Params, Entry, (
+	CR_MEMBER(key),
+	CR_MEMBER(param)
+))
+
+CR_BIND(Params,)
+CR_REG_METADATA(Params, (
+	CR_MEMBER(entries)
+))
+
+
+static std::vector<std::string> keyNames;
+static spring::unordered_map<std::string, int> nameKeys;
+
+
+int LuaRulesParams::GetKey(const std::string& name)
+{
+	const auto it = nameKeys.find(name);
+
+	if (it == nameKeys.end())
+		return -1;
+
+	return it->second;
+}
+
+int LuaRulesParams::GetOrAddKey(const std::string& name)
+{
+	const auto pair = nameKeys.insert({name, int(keyNames.size())});
+
+	if (pair.second)
+		keyNames.push_back(name);
+
+	return pair.first->second;
+}
+
+const std::string& LuaRulesParams::GetKeyName(int key)
+{
+	return keyNames[key];
+}
+
+
+void LuaRulesParams::ClearKeys()
+{
+	keyNames.clear();
+	spring::clear_unordered_map(nameKeys);
+}
+
+void LuaRulesParams::SerializeKeys(creg::ISerializer* s)
+{
+	std::unique_ptr<creg::IType> namesType = creg::DeduceType<decltype(keyNames)>::Get();
+	namesType->Serialize(s, &keyNames);
+
+	if (s->IsWriting())
+		return;
+
+	spring::clear_unordered_map(nameKeys);
+
+	for (size_t i = 0; i < keyNames.size(); i++) {
+		nameKeys[keyNames[i]] = i;
+	}
+}
@@ -3,12 +3,17 @@
 #ifndef LUA_RULESPARAMS_H
 #define LUA_RULESPARAMS_H
 
+#include <algorithm>
 #include <string>
 #include <variant>
+#include <vector>
 
-#include "System/UnorderedMap.hpp"
 #include "System/creg/creg_cond.h"
 
+namespace creg {
+	class ISerializer;
+}
+
 namespace LuaRulesParams
 {
 	enum {
@@ -35,7 +40,85 @@ namespace LuaRulesParams
 		std::variant <bool, float, std::string> value;
 	};
 
-	typedef spring::unordered_map<std::string, Param> Params;
+	/**
+	 * Param names are interned into small integer keys, shared by all params
+	 * containers. Keys are only ever created by synced code (SetXRulesParam)
+	 * so they are assigned in the same order on all clients, and they stay
+	 * valid until the game ends.
+	 */
+	/// @return the key for <name>, or -1 if no param of that name was ever set
+	int GetKey(const std::string& name);
+	/// same as GetKey, but assigns a new key to unknown names; synced only
+	int GetOrAddKey(const std::string& name);
+	const std::string& GetKeyName(int key);
+
+	void ClearKeys();
+	void SerializeKeys(creg::ISerializer* s);
+
+
+	/// flat vector of params, sorted by key
+	class Params {
+		CR_DECLARE_STRUCT(Params)
+
+	public:
+		struct Entry {
+			CR_DECLARE_STRUCT(Entry)
+
+			int key = -1;
+			Param param;
+		};
+
+		typedef std::vector<Entry>::const_iterator const_iterator;
+
+	public:
+		const Param* Find(int key) const {
+			const auto it = LowerBound(key);
+
+			if (it == entries.end() || it->key != key)
+				return nullptr;
+
+			return &it->param;
+		}
+		const Param* Find(const std::string& name) const { return Find(GetKey(name)); }
+
+		/// inserts a default-constructed param if <key> is not present yet
+		Param& Get(int key) {
+			const auto it = LowerBound(key);
+
+			if (it != entries.end() && it->key == key)
+				return it->param;
+
+			return (entries.insert(it, {key, {}}))->param;
+		}
+
+		void Erase(int key) {
+			const auto it = LowerBound(key);
+
+			if (it == entries.end() || it->key != key)
+				return;
+
+			entries.erase(it);
+		}
+
+		void clear() { entries.clear(); }
+
+		bool empty() const { return entries.empty(); }
+		size_t size() const { return entries.size(); }
+
+		const_iterator begin() const { return entries.begin(); }
+		const_iterator end() const { return entries.end(); }
+
+	private:
+		std::vector<Entry>::iterator LowerBound(int key) {
+			return std::lower_bound(entries.begin(), entries.end(), key, [](const Entry& e, int k) { return (e.key < k); });
+		}
+		std::vector<Entry>::const_iterator LowerBound(int key) const {
+			return std::lower_bound(entries.begin(), entries.end(), key, [](const Entry& e, int k) { return (e.key < k); });
+		}
+
+	private:
+		std::vector<Entry> entries;
+	};
 }
 
 #endif // LUA_RULESPARAMS_H
@@ -0,0 +1,84 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "LuaSyncedChannels.h"
+
+
+void LuaSyncedChannels::Clear()
+{
+	channels.clear();
+	strings.clear();
+
+	channelIndices.clear();
+	stringIndices.clear();
+}
+
+
+int LuaSyncedChannels::GetChannel(const std::string& name) const
+{
+	const auto iter = channelIndices.find(name);
+
+	if (iter == channelIndices.end())
+		return -1;
+
+	return iter->second;
+}
+
+int LuaSyncedChannels::GetOrAddChannel(const std::string& name)
+{
+	const auto pair = channelIndices.emplace(name, channels.size());
+
+	if (pair.second)
+		channels.emplace_back();
+
+	return pair.first->second;
+}
+
+
+std::vector<LuaSyncedChannels::Value>& LuaSyncedChannels::GetWriteValues(int channel, int frame)
+{
+	Channel& c = channels[channel];
+	Slot& s = c.slots[GetSlotIndex(frame)];
+
+	if (s.frame != frame) {
+		// keeps its capacity, channels written every frame stop allocating
+		s.frame = frame;
+		s.values.clear();
+	}
+
+	c.lastFrame = frame;
+	return s.values;
+}
+
+const LuaSyncedChannels::Slot* LuaSyncedChannels::GetReadSlot(int channel, int frame) const
+{
+	if (frame < 0)
+		return nullptr;
+	// views can outlive a Clear
+	if (channel >= int(channels.size()))
+		return nullptr;
+
+	const Slot& s = channels[channel].slots[GetSlotIndex(frame)];
+
+	if (s.frame != frame)
+		return nullptr;
+
+	return &s;
+}
+
+
+int LuaSyncedChannels::InternString(const std::string& str)
+{
+	const auto iter = stringIndices.find(str);
+
+	if (iter != stringIndices.end())
+		return iter->second;
+	if (strings.size() >= MAX_STRINGS)
+		return -1;
+
+	const auto pair = stringIndices.emplace(str, strings.size());
+
+	if (pair.second)
+		strings.push_back(str);
+
+	return pair.first->second;
+}
@@ -0,0 +1,88 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_SYNCED_CHANNELS_H
+#define LUA_SYNCED_CHANNELS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "System/UnorderedMap.hpp"
+
+/**
+ * @brief Named value channels from a synced Lua handle to its unsynced half
+ *
+ * Synced code appends numbers, booleans and strings to a channel; unsynced
+ * code reads them in place through a view instead of getting every value
+ * copied into its own state as with SendToUnsynced. Each channel keeps the
+ * values of its last NUM_FRAME_SLOTS frames in a ring of reused slots, a slot
+ * is overwritten by the first write in a frame that maps to it.
+ *
+ * Strings are interned once for the whole set and stored by index, so they
+ * should come from a small set of recurring names rather than be unique; the
+ * table is never pruned, past MAX_STRINGS distinct strings new ones are
+ * rejected.
+ */
+class LuaSyncedChannels
+{
+public:
+	static constexpr int NUM_FRAME_SLOTS = 16;
+	static constexpr int MAX_STRINGS = 1 << 16;
+
+	struct Value {
+		enum : uint8_t {
+			TYPE_NUMBER = 0,
+			TYPE_BOOL   = 1,
+			TYPE_STRING = 2,
+		};
+
+		uint8_t type;
+
+		union {
+			float number;
+			bool boolean;
+			int string;
+		};
+	};
+
+	struct Slot {
+		int frame = -1;
+		std::vector<Value> values;
+	};
+
+public:
+	void Clear();
+
+	/// @return -1 if <name> has never been written to
+	int GetChannel(const std::string& name) const;
+	int GetOrAddChannel(const std::string& name);
+
+	/// values of <channel> written in <frame>, started fresh if this is the frame's first write
+	std::vector<Value>& GetWriteValues(int channel, int frame);
+	/// @return nullptr if nothing was written in <frame> or its slot was reused since
+	const Slot* GetReadSlot(int channel, int frame) const;
+	/// @return frame of the last write to <channel>, -1 if none
+	int GetLastFrame(int channel) const { return channels[channel].lastFrame; }
+
+	/// @return -1 if <str> is new and MAX_STRINGS are already interned
+	int InternString(const std::string& str);
+	const std::string& GetString(int index) const { return strings[index]; }
+
+private:
+	struct Channel {
+		int lastFrame = -1;
+		std::array<Slot, NUM_FRAME_SLOTS> slots;
+	};
+
+	static int GetSlotIndex(int frame) { return (frame & (NUM_FRAME_SLOTS - 1)); }
+
+private:
+	std::vector<Channel> channels;
+	std::vector<std::string> strings;
+
+	spring::unordered_map<std::string, int> channelIndices;
+	spring::unordered_map<std::string, int> stringIndices;
+};
+
+#endif /* LUA_SYNCED_CHANNELS_H */
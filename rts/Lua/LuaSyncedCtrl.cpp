@@ -152,6 +152,7 @@ bool LuaSyncedCtrl::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(SetTeamRulesParam);
 	REGISTER_LUA_CFUNC(SetPlayerRulesParam);
 	REGISTER_LUA_CFUNC(SetUnitRulesParam);
+	REGISTER_LUA_CFUNC(SetUnitsRulesParam);
 	REGISTER_LUA_CFUNC(SetFeatureRulesParam);
 
 	REGISTER_LUA_CFUNC(CreateUnit);
@@ -1289,16 +1290,46 @@ int LuaSyncedCtrl::ShareTeamResource(lua_State* L)
  */
 
 
-void SetRulesParam(lua_State* L, const char* caller, int offset,
-				LuaRulesParams::Params& params)
+// @return the param's new los mask, or -1 if it should be left as-is
+static int ParseRulesParamLos(lua_State* L, int losIndex)
 {
-	const int index = offset + 1;
-	const int valIndex = offset + 2;
-	const int losIndex = offset + 3; // table
+	if (!lua_istable(L, losIndex))
+		return luaL_optint(L, losIndex, -1);
+
+	int losMask = LuaRulesParams::RULESPARAMLOS_PRIVATE;
+
+	for (lua_pushnil(L); lua_next(L, losIndex) != 0; lua_pop(L, 1)) {
+		// ignore if the value is false
+		if (!luaL_optboolean(L, -1, true))
+			continue;
+
+		// read the losType from the key
+		if (!lua_isstring(L, -2))
+			continue;
+
+		switch (hashString(lua_tostring(L, -2))) {
+			case hashString("public" ): { losMask |= LuaRulesParams::RULESPARAMLOS_PUBLIC;  } break;
+			case hashString("inlos"  ): { losMask |= LuaRulesParams::RULESPARAMLOS_INLOS;   } break;
+			case hashString("typed"  ): { losMask |= LuaRulesParams::RULESPARAMLOS_TYPED;   } break;
+			case hashString("inradar"): { losMask |= LuaRulesParams::RULESPARAMLOS_INRADAR; } break;
+			case hashString("allied" ): { losMask |= LuaRulesParams::RULESPARAMLOS_ALLIED;  } break;
+			// case hashString("private"): { losMask |= LuaRulesParams::RULESPARAMLOS_PRIVATE; } break;
+			default                   : {                                                   } break;
+		}
+	}
+
+	return losMask;
+}
 
-	const std::string& key = luaL_checkstring(L, index);
+static void SetRulesParamValue(lua_State* L, const char* caller, int valIndex, int losMask,
+				LuaRulesParams::Params& params, int key)
+{
+	if (lua_isnoneornil(L, valIndex)) {
+		params.Erase(key);
+		return; //no need to set los if param was erased
+	}
 
-	LuaRulesParams::Param& param = params[key];
+	LuaRulesParams::Param& param = params.Get(key);
 
 	// set the value of the parameter
 	if (lua_israwnumber(L, valIndex)) {
@@ -1307,42 +1338,27 @@ void SetRulesParam(lua_State* L, const char* caller, int offset,
 		param.value.emplace <bool> (lua_toboolean(L, valIndex));
 	} else if (lua_isstring(L, valIndex)) {
 		param.value.emplace <std::string> (lua_tostring(L, valIndex));
-	} else if (lua_isnoneornil(L, valIndex)) {
-		params.erase(key);
-		return; //no need to set los if param was erased
 	} else {
-		params.erase(key);
+		params.Erase(key);
 		luaL_error(L, "Incorrect arguments to %s()", caller);
 	}
 
 	// set the los checking of the parameter
-	if (lua_istable(L, losIndex)) {
-		int losMask = LuaRulesParams::RULESPARAMLOS_PRIVATE;
-
-		for (lua_pushnil(L); lua_next(L, losIndex) != 0; lua_pop(L, 1)) {
-			// ignore if the value is false
-			if (!luaL_optboolean(L, -1, true))
-				continue;
+	if (losMask >= 0)
+		param.los = losMask;
+}
 
-			// read the losType from the key
-			if (!lua_isstring(L, -2))
-				continue;
+void SetRulesParam(lua_State* L, const char* caller, int offset,
+				LuaRulesParams::Params& params)
+{
+	const int index = offset + 1;
+	const int valIndex = offset + 2;
+	const int losIndex = offset + 3; // table
 
-			switch (hashString(lua_tostring(L, -2))) {
-				case hashString("public" ): { losMask |= LuaRulesParams::RULESPARAMLOS_PUBLIC;  } break;
-				case hashString("inlos"  ): { losMask |= LuaRulesParams::RULESPARAMLOS_INLOS;   } break;
-				case hashString("typed"  ): { losMask |= LuaRulesParams::RULESPARAMLOS_TYPED;   } break;
-				case hashString("inradar"): { losMask |= LuaRulesParams::RULESPARAMLOS_INRADAR; } break;
-				case hashString("allied" ): { losMask |= LuaRulesParams::RULESPARAMLOS_ALLIED;  } break;
-				// case hashString("private"): { losMask |= LuaRulesParams::RULESPARAMLOS_PRIVATE; } break;
-				default                   : {                                                   } break;
-			}
-		}
+	// only synced code creates keys, see LuaRulesParams::GetKey
+	const int key = LuaRulesParams::GetOrAddKey(luaL_checkstring(L, index));
 
-		param.los = losMask;
-	} else {
-		param.los = luaL_optint(L, losIndex, param.los);
-	}
+	SetRulesParamValue(L, caller, valIndex, ParseRulesParamLos(L, losIndex), params, key);
 }
 
 
@@ -1422,6 +1438,48 @@ int LuaSyncedCtrl::SetUnitRulesParam(lua_State* L)
 }
 
 
+/***
+ * Sets the same rules param on many units at once, equivalent to calling
+ * SetUnitRulesParam for each of them but with a single param name lookup.
+ *
+ * @function Spring.SetUnitsRulesParam
+ * @tparam {number,...} unitIDs
+ * @string paramName
+ * @tparam ?number|string|{[number]=number|string,...} paramValue either a single value for all units, or a table with one value per entry of unitIDs (nil entries remove the param)
+ * @tparam[opt] losAccess losAccess
+ * @treturn nil
+ */
+int LuaSyncedCtrl::SetUnitsRulesParam(lua_State* L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	const int key = LuaRulesParams::GetOrAddKey(luaL_checkstring(L, 2));
+	const int losMask = ParseRulesParamLos(L, 4);
+	const int numUnits = lua_objlen(L, 1);
+	const bool perUnitValues = lua_istable(L, 3);
+
+	for (int i = 1; i <= numUnits; i++) {
+		lua_rawgeti(L, 1, i);
+		CUnit* unit = ParseUnit(L, __func__, -1);
+		lua_pop(L, 1);
+
+		if (unit == nullptr)
+			continue;
+
+		if (!perUnitValues) {
+			SetRulesParamValue(L, __func__, 3, losMask, unit->modParams, key);
+			continue;
+		}
+
+		lua_rawgeti(L, 3, i);
+		SetRulesParamValue(L, __func__, lua_gettop(L), losMask, unit->modParams, key);
+		lua_pop(L, 1);
+	}
+
+	return 0;
+}
+
+
 /***
  * @function Spring.SetFeatureRulesParam
  * @number featureID
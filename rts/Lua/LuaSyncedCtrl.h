@@ -54,6 +54,7 @@ class LuaSyncedCtrl
 		static int SetTeamRulesParam(lua_State* L);
 		static int SetPlayerRulesParam(lua_State* L);
 		static int SetUnitRulesParam(lua_State* L);
+		static int SetUnitsRulesParam(lua_State* L);
 		static int SetFeatureRulesParam(lua_State* L);
 
 		static int UnitFinishCommand(lua_State* L);
@@ -76,6 +76,7 @@
 #include "System/FileSystem/FileSystem.h"
 #include "System/StringUtil.h"
 
+#include <array>
 #include <cctype>
 #include <type_traits>
 
@@ -195,6 +196,7 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetUnitAllyTeam);
 	REGISTER_LUA_CFUNC(GetUnitNeutral);
 	REGISTER_LUA_CFUNC(GetUnitHealth);
+	REGISTER_LUA_CFUNC(GetUnitsHealths);
 	REGISTER_LUA_CFUNC(GetUnitIsDead);
 	REGISTER_LUA_CFUNC(GetUnitIsStunned);
 	REGISTER_LUA_CFUNC(GetUnitIsBeingBuilt);
@@ -215,12 +217,14 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetUnitBuildeeRadius);
 	REGISTER_LUA_CFUNC(GetUnitMass);
 	REGISTER_LUA_CFUNC(GetUnitPosition);
+	REGISTER_LUA_CFUNC(GetUnitsPositions);
 	REGISTER_LUA_CFUNC(GetUnitBasePosition);
 	REGISTER_LUA_CFUNC(GetUnitVectors);
 	REGISTER_LUA_CFUNC(GetUnitRotation);
 	REGISTER_LUA_CFUNC(GetUnitDirection);
 	REGISTER_LUA_CFUNC(GetUnitHeading);
 	REGISTER_LUA_CFUNC(GetUnitVelocity);
+	REGISTER_LUA_CFUNC(GetUnitsVelocities);
 	REGISTER_LUA_CFUNC(GetUnitBuildFacing);
 	REGISTER_LUA_CFUNC(GetUnitIsBuilding);
 	REGISTER_LUA_CFUNC(GetUnitWorkerTask);
@@ -274,6 +278,7 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 
 	REGISTER_LUA_CFUNC(GetUnitRulesParam);
 	REGISTER_LUA_CFUNC(GetUnitRulesParams);
+	REGISTER_LUA_CFUNC(GetUnitsRulesParam);
 
 	REGISTER_LUA_CFUNC(GetCEGID);
 
@@ -631,6 +636,90 @@ static inline const CUnit* ParseTypedUnit(lua_State* L, const char* caller, int
 }
 
 
+/******************************************************************************/
+
+// access rights of the calling handle, looked up once per bulk query
+// (same rules as LuaUtils::IsAllyUnit / IsUnitVisible / IsUnitInLos)
+struct UnitReadAccess {
+	UnitReadAccess(lua_State* L)
+		: readAllyTeam(CLuaHandle::GetHandleReadAllyTeam(L))
+		, fullRead(CLuaHandle::GetHandleFullRead(L))
+	{}
+
+	bool IsAlly(const CUnit* unit) const {
+		if (readAllyTeam < 0)
+			return fullRead;
+
+		return (unit->allyteam == readAllyTeam);
+	}
+	bool IsVisible(const CUnit* unit) const {
+		return (IsAlly(unit) || (readAllyTeam >= 0 && (unit->losStatus[readAllyTeam] & (LOS_INLOS | LOS_INRADAR))));
+	}
+	bool IsInLos(const CUnit* unit) const {
+		return (IsAlly(unit) || (readAllyTeam >= 0 && (unit->losStatus[readAllyTeam] & LOS_INLOS)));
+	}
+
+	int readAllyTeam;
+	bool fullRead;
+};
+
+/**
+ * Fills a flat array with N values per entry of the unitIDs table at index 1,
+ * in the table at index 2 if one is given (stale entries past the end of the
+ * new data are cleared) or a new one otherwise. Units for which getValues()
+ * returns false get N false values, so the array never has holes.
+ */
+template<size_t N, typename GetValuesFunc>
+static int PushUnitsValues(lua_State* L, GetValuesFunc&& getValues)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	const int numUnits = lua_objlen(L, 1);
+	const int numValues = numUnits * N;
+
+	if (lua_istable(L, 2)) {
+		lua_pushvalue(L, 2);
+	} else {
+		lua_createtable(L, numValues, 0);
+	}
+
+	std::array<float, N> values;
+
+	for (int i = 0; i < numUnits; i++) {
+		lua_rawgeti(L, 1, i + 1);
+		const CUnit* unit = lua_isnumber(L, -1)? unitHandler.GetUnit(lua_toint(L, -1)): nullptr;
+		lua_pop(L, 1);
+
+		const bool valid = (unit != nullptr && getValues(unit, values));
+
+		for (size_t k = 0; k < N; k++) {
+			if (valid) {
+				lua_pushnumber(L, values[k]);
+			} else {
+				lua_pushboolean(L, false);
+			}
+
+			lua_rawseti(L, -2, i * N + k + 1);
+		}
+	}
+
+	for (int j = numValues + 1; ; j++) {
+		lua_rawgeti(L, -1, j);
+
+		if (lua_isnil(L, -1)) {
+			lua_pop(L, 1);
+			break;
+		}
+
+		lua_pop(L, 1);
+		lua_pushnil(L);
+		lua_rawseti(L, -2, j);
+	}
+
+	return 1;
+}
+
+
 static const CFeature* ParseFeature(lua_State* L, const char* caller, int index)
 {
 	if (!lua_isnumber(L, index)) {
@@ -684,9 +773,9 @@ static int PushRulesParams(lua_State* L, const char* caller,
 {
 	lua_createtable(L, 0, params.size());
 
-	for (const auto& it: params) {
-		const std::string& name = it.first;
-		const LuaRulesParams::Param& param = it.second;
+	for (const auto& entry: params) {
+		const std::string& name = LuaRulesParams::GetKeyName(entry.key);
+		const LuaRulesParams::Param& param = entry.param;
 		if (!(param.los & losStatus))
 			continue;
 
@@ -705,19 +794,8 @@ static int PushRulesParams(lua_State* L, const char* caller,
 }
 
 
-static int GetRulesParam(lua_State* L, const char* caller, int index,
-                          const LuaRulesParams::Params& params,
-                          const int& losStatus)
+static void PushRulesParamValue(lua_State* L, const LuaRulesParams::Param& param)
 {
-	const std::string& key = luaL_checkstring(L, index);
-	const auto it = params.find(key);
-	if (it == params.end())
-		return 0;
-
-	const LuaRulesParams::Param& param = it->second;
-	if (!(param.los & losStatus))
-		return 0;
-
 	std::visit ([L](auto&& value) {
 		using T = std::decay_t <decltype(value)>;
 		if constexpr (std::is_same_v <T, float>)
@@ -727,7 +805,19 @@ static int GetRulesParam(lua_State* L, const char* caller, int index,
 		else if constexpr (std::is_same_v <T, std::string>)
 			lua_pushsstring(L, value);
 	}, param.value);
+}
 
+static int GetRulesParam(lua_State* L, const char* caller, int index,
+                          const LuaRulesParams::Params& params,
+                          const int& losStatus)
+{
+	const LuaRulesParams::Param* param = params.Find(luaL_checkstring(L, index));
+	if (param == nullptr)
+		return 0;
+	if (!(param->los & losStatus))
+		return 0;
+
+	PushRulesParamValue(L, *param);
 	return 1;
 }
 
@@ -1206,6 +1296,50 @@ int LuaSyncedRead::GetUnitRulesParam(lua_State* L)
 }
 
 
+/***
+ * Reads the same rules param from many units at once, equivalent to calling
+ * GetUnitRulesParam for each of them but with a single param name lookup.
+ *
+ * @function Spring.GetUnitsRulesParam
+ *
+ * @tparam {number,...} unitIDs
+ * @string paramName
+ *
+ * @treturn {[number]=number|string,...} values one entry per entry of unitIDs, nil where the unit or param is not (visibly) present
+ */
+int LuaSyncedRead::GetUnitsRulesParam(lua_State* L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	const int key = LuaRulesParams::GetKey(luaL_checkstring(L, 2));
+	const int numUnits = lua_objlen(L, 1);
+
+	lua_createtable(L, numUnits, 0);
+
+	if (key < 0 || game == nullptr)
+		return 1;
+
+	for (int i = 1; i <= numUnits; i++) {
+		lua_rawgeti(L, 1, i);
+		const CUnit* unit = ParseUnit(L, __func__, -1);
+		lua_pop(L, 1);
+
+		if (unit == nullptr)
+			continue;
+
+		const LuaRulesParams::Param* param = unit->modParams.Find(key);
+
+		if (param == nullptr || !(param->los & GetUnitRulesParamLosMask(L, unit)))
+			continue;
+
+		PushRulesParamValue(L, *param);
+		lua_rawseti(L, -2, i);
+	}
+
+	return 1;
+}
+
+
 /***
  *
  * @function Spring.GetFeatureRulesParam
@@ -2797,23 +2931,93 @@ int LuaSyncedRead::GetTeamUnitCount(lua_State* L)
 ******************************************************************************/
 
 
+/**
+ * Receives the unitIDs found by a spatial query. By default they are put in a
+ * new table; if the query got an output table it is refilled in place (avoids
+ * a new table per call), and if it got a function that is called with each
+ * unitID instead, so no table is materialized at all. A callback can return
+ * true to end the query early.
+ *
+ * The IDs are only collected by Add, nothing touches Lua before Finish; call
+ * that after the QuadFieldQuery went out of scope, a callback might run other
+ * queries and there are only a few query vectors per thread.
+ */
+class SpatialQueryResults {
+public:
+	SpatialQueryResults(lua_State* _L, int _outIndex): L(_L), outIndex(_outIndex) {
+		callback = lua_isfunction(L, outIndex);
+	}
+
+	void Reserve(size_t n) { objectIDs.reserve(n); }
+	void Add(int objectID) { objectIDs.push_back(objectID); }
+
+	// @return the number of Lua return values
+	int Finish() {
+		if (callback) {
+			for (const int objectID: objectIDs) {
+				lua_pushvalue(L, outIndex);
+				lua_pushnumber(L, objectID);
+				lua_call(L, 1, 1);
+
+				const bool stop = lua_toboolean(L, -1);
+				lua_pop(L, 1);
+
+				if (stop)
+					break;
+			}
+
+			return 0;
+		}
+
+		if (lua_istable(L, outIndex)) {
+			lua_pushvalue(L, outIndex);
+		} else {
+			lua_createtable(L, objectIDs.size(), 0);
+		}
+
+		const int tableIndex = lua_gettop(L);
+
+		for (size_t i = 0; i < objectIDs.size(); i++) {
+			lua_pushnumber(L, objectIDs[i]);
+			lua_rawseti(L, tableIndex, i + 1);
+		}
+
+		// drop leftovers from a previous (longer) result in a reused table
+		for (int i = objectIDs.size() + 1; ; i++) {
+			lua_rawgeti(L, tableIndex, i);
+
+			if (lua_isnil(L, -1)) {
+				lua_pop(L, 1);
+				break;
+			}
+
+			lua_pop(L, 1);
+			lua_pushnil(L);
+			lua_rawseti(L, tableIndex, i);
+		}
+
+		return 1;
+	}
+
+private:
+	lua_State* L;
+
+	int outIndex = 0;
+	bool callback = false;
+
+	std::vector<int> objectIDs;
+};
+
+
 // Macro Requirements:
-//   L, units
-
-#define LOOP_UNIT_CONTAINER(ALLEGIANCE_TEST, CUSTOM_TEST, NEWTABLE) \
-	{                                                               \
-		unsigned int count = 0;                                     \
-                                                                    \
-		if (NEWTABLE)                                               \
-			lua_createtable(L, units.size(), 0);                    \
-                                                                    \
-		for (const CUnit* unit: units) {                            \
-			ALLEGIANCE_TEST;                                        \
-			CUSTOM_TEST;                                            \
-                                                                    \
-			lua_pushnumber(L, unit->id);                            \
-			lua_rawseti(L, -2, ++count);                            \
-		}                                                           \
+//   L, units, results
+
+#define LOOP_UNIT_CONTAINER(ALLEGIANCE_TEST, CUSTOM_TEST) \
+	for (const CUnit* unit: units) {                      \
+		ALLEGIANCE_TEST;                                  \
+		CUSTOM_TEST;                                      \
+                                                          \
+		results.Add(unit->id);                            \
 	}
 
 // Macro Requirements:
@@ -2852,7 +3056,8 @@ int LuaSyncedRead::GetTeamUnitCount(lua_State* L)
  * @number xmax
  * @number zmax
  * @number[opt] allegiance
- * @treturn {number,...} unitIDs
+ * @tparam[opt] table|function out table to refill in place instead of allocating a new one, or a function that is called with each unitID instead (return true to stop early)
+ * @treturn nil|{number,...} unitIDs (nothing if out is a function)
  */
 int LuaSyncedRead::GetUnitsInRectangle(lua_State* L)
 {
@@ -2868,32 +3073,38 @@ int LuaSyncedRead::GetUnitsInRectangle(lua_State* L)
 
 #define RECTANGLE_TEST ; // no test, GetUnitsExact is sufficient
 
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, mins, maxs);
-	const auto& units = (*qfQuery.units);
+	SpatialQueryResults results(L, 6);
 
-	if (allegiance >= 0) {
-		if (LuaUtils::IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, RECTANGLE_TEST, true);
-		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, RECTANGLE_TEST, true);
+	{
+		QuadFieldQuery qfQuery;
+		quadField.GetUnitsExact(qfQuery, mins, maxs);
+		const auto& units = (*qfQuery.units);
+
+		results.Reserve(units.size());
+
+		if (allegiance >= 0) {
+			if (LuaUtils::IsAlliedTeam(L, allegiance)) {
+				LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, RECTANGLE_TEST);
+			} else {
+				LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, RECTANGLE_TEST);
+			}
+		}
+		else if (allegiance == LuaUtils::MyUnits) {
+			const int readTeam = CLuaHandle::GetHandleReadTeam(L);
+			LOOP_UNIT_CONTAINER(MY_UNIT_TEST, RECTANGLE_TEST);
+		}
+		else if (allegiance == LuaUtils::AllyUnits) {
+			LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, RECTANGLE_TEST);
+		}
+		else if (allegiance == LuaUtils::EnemyUnits) {
+			LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, RECTANGLE_TEST);
+		}
+		else { // AllUnits
+			LOOP_UNIT_CONTAINER(VISIBLE_TEST, RECTANGLE_TEST);
 		}
-	}
-	else if (allegiance == LuaUtils::MyUnits) {
-		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, RECTANGLE_TEST, true);
-	}
-	else if (allegiance == LuaUtils::AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, RECTANGLE_TEST, true);
-	}
-	else if (allegiance == LuaUtils::EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, RECTANGLE_TEST, true);
-	}
-	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, RECTANGLE_TEST, true);
 	}
 
-	return 1;
+	return (results.Finish());
 }
 
 
@@ -2907,7 +3118,8 @@ int LuaSyncedRead::GetUnitsInRectangle(lua_State* L)
  * @number ymax
  * @number zmax
  * @number[opt] allegiance
- * @treturn {number,...} unitIDs
+ * @tparam[opt] table|function out table to refill in place instead of allocating a new one, or a function that is called with each unitID instead (return true to stop early)
+ * @treturn nil|{number,...} unitIDs (nothing if out is a function)
  */
 int LuaSyncedRead::GetUnitsInBox(lua_State* L)
 {
@@ -2929,32 +3141,38 @@ int LuaSyncedRead::GetUnitsInBox(lua_State* L)
 		continue;                     \
 	}
 
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, mins, maxs);
-	const auto& units = (*qfQuery.units);
+	SpatialQueryResults results(L, 8);
 
-	if (allegiance >= 0) {
-		if (LuaUtils::IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, BOX_TEST, true);
-		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, BOX_TEST, true);
+	{
+		QuadFieldQuery qfQuery;
+		quadField.GetUnitsExact(qfQuery, mins, maxs);
+		const auto& units = (*qfQuery.units);
+
+		results.Reserve(units.size());
+
+		if (allegiance >= 0) {
+			if (LuaUtils::IsAlliedTeam(L, allegiance)) {
+				LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, BOX_TEST);
+			} else {
+				LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, BOX_TEST);
+			}
+		}
+		else if (allegiance == LuaUtils::MyUnits) {
+			const int readTeam = CLuaHandle::GetHandleReadTeam(L);
+			LOOP_UNIT_CONTAINER(MY_UNIT_TEST, BOX_TEST);
+		}
+		else if (allegiance == LuaUtils::AllyUnits) {
+			LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, BOX_TEST);
+		}
+		else if (allegiance == LuaUtils::EnemyUnits) {
+			LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, BOX_TEST);
+		}
+		else { // AllUnits
+			LOOP_UNIT_CONTAINER(VISIBLE_TEST, BOX_TEST);
 		}
-	}
-	else if (allegiance == LuaUtils::MyUnits) {
-		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, BOX_TEST, true);
-	}
-	else if (allegiance == LuaUtils::AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, BOX_TEST, true);
-	}
-	else if (allegiance == LuaUtils::EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, BOX_TEST, true);
-	}
-	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, BOX_TEST, true);
 	}
 
-	return 1;
+	return (results.Finish());
 }
 
 
@@ -2964,7 +3182,9 @@ int LuaSyncedRead::GetUnitsInBox(lua_State* L)
  * @number x
  * @number z
  * @number radius
- * @treturn {number,...} unitIDs
+ * @number[opt] allegiance
+ * @tparam[opt] table|function out table to refill in place instead of allocating a new one, or a function that is called with each unitID instead (return true to stop early)
+ * @treturn nil|{number,...} unitIDs (nothing if out is a function)
  */
 int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
 {
@@ -2987,32 +3207,38 @@ int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
 		continue;                               \
 	}                                           \
 
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, mins, maxs);
-	const auto& units = (*qfQuery.units);
+	SpatialQueryResults results(L, 5);
 
-	if (allegiance >= 0) {
-		if (LuaUtils::IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, CYLINDER_TEST, true);
-		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, CYLINDER_TEST, true);
+	{
+		QuadFieldQuery qfQuery;
+		quadField.GetUnitsExact(qfQuery, mins, maxs);
+		const auto& units = (*qfQuery.units);
+
+		results.Reserve(units.size());
+
+		if (allegiance >= 0) {
+			if (LuaUtils::IsAlliedTeam(L, allegiance)) {
+				LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, CYLINDER_TEST);
+			} else {
+				LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, CYLINDER_TEST);
+			}
+		}
+		else if (allegiance == LuaUtils::MyUnits) {
+			const int readTeam = CLuaHandle::GetHandleReadTeam(L);
+			LOOP_UNIT_CONTAINER(MY_UNIT_TEST, CYLINDER_TEST);
+		}
+		else if (allegiance == LuaUtils::AllyUnits) {
+			LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, CYLINDER_TEST);
+		}
+		else if (allegiance == LuaUtils::EnemyUnits) {
+			LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, CYLINDER_TEST);
+		}
+		else { // AllUnits
+			LOOP_UNIT_CONTAINER(VISIBLE_TEST, CYLINDER_TEST);
 		}
-	}
-	else if (allegiance == LuaUtils::MyUnits) {
-		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, CYLINDER_TEST, true);
-	}
-	else if (allegiance == LuaUtils::AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, CYLINDER_TEST, true);
-	}
-	else if (allegiance == LuaUtils::EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, CYLINDER_TEST, true);
-	}
-	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, CYLINDER_TEST, true);
 	}
 
-	return 1;
+	return (results.Finish());
 }
 
 
@@ -3023,7 +3249,9 @@ int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
  * @number y
  * @number z
  * @number radius
- * @treturn {number,...} unitIDs
+ * @number[opt] allegiance
+ * @tparam[opt] table|function out table to refill in place instead of allocating a new one, or a function that is called with each unitID instead (return true to stop early)
+ * @treturn nil|{number,...} unitIDs (nothing if out is a function)
  */
 int LuaSyncedRead::GetUnitsInSphere(lua_State* L)
 {
@@ -3050,32 +3278,38 @@ int LuaSyncedRead::GetUnitsInSphere(lua_State* L)
 		continue;                                 \
 	}                                           \
 
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, mins, maxs);
-	const auto& units = (*qfQuery.units);
+	SpatialQueryResults results(L, 6);
 
-	if (allegiance >= 0) {
-		if (LuaUtils::IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, SPHERE_TEST, true);
-		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, SPHERE_TEST, true);
+	{
+		QuadFieldQuery qfQuery;
+		quadField.GetUnitsExact(qfQuery, mins, maxs);
+		const auto& units = (*qfQuery.units);
+
+		results.Reserve(units.size());
+
+		if (allegiance >= 0) {
+			if (LuaUtils::IsAlliedTeam(L, allegiance)) {
+				LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, SPHERE_TEST);
+			} else {
+				LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, SPHERE_TEST);
+			}
+		}
+		else if (allegiance == LuaUtils::MyUnits) {
+			const int readTeam = CLuaHandle::GetHandleReadTeam(L);
+			LOOP_UNIT_CONTAINER(MY_UNIT_TEST, SPHERE_TEST);
+		}
+		else if (allegiance == LuaUtils::AllyUnits) {
+			LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, SPHERE_TEST);
+		}
+		else if (allegiance == LuaUtils::EnemyUnits) {
+			LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, SPHERE_TEST);
+		}
+		else { // AllUnits
+			LOOP_UNIT_CONTAINER(VISIBLE_TEST, SPHERE_TEST);
 		}
-	}
-	else if (allegiance == LuaUtils::MyUnits) {
-		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, SPHERE_TEST, true);
-	}
-	else if (allegiance == LuaUtils::AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, SPHERE_TEST, true);
-	}
-	else if (allegiance == LuaUtils::EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, SPHERE_TEST, true);
-	}
-	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, SPHERE_TEST, true);
 	}
 
-	return 1;
+	return (results.Finish());
 }
 
 
@@ -3117,7 +3351,8 @@ static inline bool UnitInPlanes(const CUnit* unit, const vector<Plane>& planes)
  *
  * @tparam {planeSpec,...} planes
  * @number[opt] allegiance
- * @treturn nil|{number,...} unitIDs
+ * @tparam[opt] table|function out table to refill in place instead of allocating a new one, or a function that is called with each unitID instead (return true to stop early)
+ * @treturn nil|{number,...} unitIDs (nothing if out is a function)
  */
 int LuaSyncedRead::GetUnitsInPlanes(lua_State* L)
 {
@@ -3127,7 +3362,7 @@ int LuaSyncedRead::GetUnitsInPlanes(lua_State* L)
 
 	// parse the planes
 	vector<Plane> planes;
-	const int table = lua_gettop(L);
+	const int table = 1;
 	for (lua_pushnil(L); lua_next(L, table) != 0; lua_pop(L, 1)) {
 		if (lua_istable(L, -1)) {
 			float values[4];
@@ -3163,7 +3398,7 @@ int LuaSyncedRead::GetUnitsInPlanes(lua_State* L)
 
 	const int readTeam = CLuaHandle::GetHandleReadTeam(L);
 
-	lua_newtable(L);
+	SpatialQueryResults results(L, 3);
 
 	for (int team = startTeam; team <= endTeam; team++) {
 		const std::vector<CUnit*>& units = unitHandler.GetUnitsByTeam(team);
@@ -3171,37 +3406,37 @@ int LuaSyncedRead::GetUnitsInPlanes(lua_State* L)
 		if (allegiance >= 0) {
 			if (allegiance == team) {
 				if (LuaUtils::IsAlliedTeam(L, allegiance)) {
-					LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, false);
+					LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST);
 				} else {
-					LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, false);
+					LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST);
 				}
 			}
 		}
 		else if (allegiance == LuaUtils::MyUnits) {
 			if (readTeam == team) {
-				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST);
 			}
 		}
 		else if (allegiance == LuaUtils::AllyUnits) {
 			if (CLuaHandle::GetHandleReadAllyTeam(L) == teamHandler.AllyTeam(team)) {
-				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST);
 			}
 		}
 		else if (allegiance == LuaUtils::EnemyUnits) {
 			if (CLuaHandle::GetHandleReadAllyTeam(L) != teamHandler.AllyTeam(team)) {
-				LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST);
 			}
 		}
 		else { // AllUnits
 			if (LuaUtils::IsAlliedTeam(L, team)) {
-				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST);
 			} else {
-				LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST);
 			}
 		}
 	}
 
-	return 1;
+	return (results.Finish());
 }
 
 
@@ -3927,6 +4162,36 @@ int LuaSyncedRead::GetUnitHealth(lua_State* L)
 }
 
 
+/***
+ * Bulk version of GetUnitHealth.
+ *
+ * @function Spring.GetUnitsHealths
+ * @tparam {number,...} unitIDs
+ * @tparam[opt] table outTable refilled in place instead of allocating a new table
+ * @treturn {number|false,...} healths health and maxHealth of unitIDs[i] at entries 2*i-1 and 2*i, false for units not in LOS or with hidden damage
+ */
+int LuaSyncedRead::GetUnitsHealths(lua_State* L)
+{
+	const UnitReadAccess access(L);
+
+	return (PushUnitsValues<2>(L, [&](const CUnit* unit, std::array<float, 2>& values) {
+		if (!access.IsInLos(unit))
+			return false;
+
+		const UnitDef* ud = unit->unitDef;
+		const bool enemyUnit = !access.IsAlly(unit);
+
+		if (ud->hideDamage && enemyUnit)
+			return false;
+
+		const float scale = (!enemyUnit || (ud->decoyDef == nullptr))? 1.0f: (ud->decoyDef->health / ud->health);
+
+		values = {scale * unit->health, scale * unit->maxHealth};
+		return true;
+	}));
+}
+
+
 /***
  *
  * @function Spring.GetUnitIsDead
@@ -4238,6 +4503,54 @@ int LuaSyncedRead::GetUnitVelocity(lua_State* L)
 }
 
 
+/***
+ * Bulk version of GetUnitBasePosition.
+ *
+ * @function Spring.GetUnitsPositions
+ * @tparam {number,...} unitIDs
+ * @tparam[opt] table outTable refilled in place instead of allocating a new table
+ * @treturn {number|false,...} positions x, y, z of unitIDs[i] at entries 3*i-2 to 3*i, false for units that are not visible
+ */
+int LuaSyncedRead::GetUnitsPositions(lua_State* L)
+{
+	const UnitReadAccess access(L);
+
+	return (PushUnitsValues<3>(L, [&](const CUnit* unit, std::array<float, 3>& values) {
+		if (!access.IsVisible(unit))
+			return false;
+
+		float3 pos = unit->pos;
+
+		if (!access.IsAlly(unit))
+			pos += unit->GetLuaErrorVector(access.readAllyTeam, access.fullRead);
+
+		values = {pos.x, pos.y, pos.z};
+		return true;
+	}));
+}
+
+/***
+ * Bulk version of GetUnitVelocity.
+ *
+ * @function Spring.GetUnitsVelocities
+ * @tparam {number,...} unitIDs
+ * @tparam[opt] table outTable refilled in place instead of allocating a new table
+ * @treturn {number|false,...} velocities x, y, z of unitIDs[i] at entries 3*i-2 to 3*i, false for units not in LOS
+ */
+int LuaSyncedRead::GetUnitsVelocities(lua_State* L)
+{
+	const UnitReadAccess access(L);
+
+	return (PushUnitsValues<3>(L, [&](const CUnit* unit, std::array<float, 3>& values) {
+		if (!access.IsInLos(unit))
+			return false;
+
+		values = {unit->speed.x, unit->speed.y, unit->speed.z};
+		return true;
+	}));
+}
+
+
 /***
  *
  * @function Spring.GetUnitBuildFacing
@@ -105,6 +105,7 @@ class LuaSyncedRead {
 		static int GetUnitAllyTeam(lua_State* L);
 		static int GetUnitNeutral(lua_State* L);
 		static int GetUnitHealth(lua_State* L);
+		static int GetUnitsHealths(lua_State* L);
 		static int GetUnitIsDead(lua_State* L);
 		static int GetUnitIsStunned(lua_State* L);
 		static int GetUnitIsBeingBuilt(lua_State* L);
@@ -125,12 +126,14 @@ class LuaSyncedRead {
 		static int GetUnitBuildeeRadius(lua_State* L);
 		static int GetUnitMass(lua_State* L);
 		static int GetUnitPosition(lua_State* L);
+		static int GetUnitsPositions(lua_State* L);
 		static int GetUnitBasePosition(lua_State* L);
 		static int GetUnitVectors(lua_State* L);
 		static int GetUnitRotation(lua_State* L);
 		static int GetUnitDirection(lua_State* L);
 		static int GetUnitHeading(lua_State* L);
 		static int GetUnitVelocity(lua_State* L);
+		static int GetUnitsVelocities(lua_State* L);
 		static int GetUnitBuildFacing(lua_State* L);
 		static int GetUnitIsBuilding(lua_State* L);
 		static int GetUnitWorkerTask(lua_State* L);
@@ -181,6 +184,7 @@ class LuaSyncedRead {
 
 		static int GetUnitRulesParam(lua_State* L);
 		static int GetUnitRulesParams(lua_State* L);
+		static int GetUnitsRulesParam(lua_State* L);
 
 		static int GetUnitLosState(lua_State* L);
 		static int GetUnitSeparation(lua_State* L);
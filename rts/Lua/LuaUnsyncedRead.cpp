@@ -108,6 +108,7 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetProfilerRecordNames);
 
 	REGISTER_LUA_CFUNC(GetLuaMemUsage);
+	REGISTER_LUA_CFUNC(GetLuaGCStats);
 	REGISTER_LUA_CFUNC(GetVidMemUsage);
 
 	REGISTER_LUA_CFUNC(GetDrawFrame);
@@ -577,6 +578,46 @@ int LuaUnsyncedRead::GetLuaMemUsage(lua_State* L)
 }
 
 
+/***
+ * Garbage collection statistics of every Lua handle
+ *
+ * @function Spring.GetLuaGCStats
+ *
+ * @treturn {[number]={name=string,synced=bool,memUsage=number,allocRate=number,collections=number,runTime=number,lastRunTime=number,freed=number,poolSize=number,poolFragmentation=number},...}
+ * memUsage, freed and poolSize in kilobytes, allocRate in kilobytes per second, runTime and lastRunTime in milliseconds,
+ * poolFragmentation is the fraction of the state's slab memory not holding live blocks
+ */
+int LuaUnsyncedRead::GetLuaGCStats(lua_State* L)
+{
+	extern const spring::unsynced_set<const luaContextData*>* LUAHANDLE_CONTEXTS[2];
+
+	lua_createtable(L, LUAHANDLE_CONTEXTS[0]->size() + LUAHANDLE_CONTEXTS[1]->size(), 0);
+
+	int count = 0;
+
+	for (bool synced: {false, true}) {
+		for (const luaContextData* lcd: *LUAHANDLE_CONTEXTS[synced]) {
+			const SLuaGarbageCollectCtrl& gcCtrl = lcd->gcCtrl;
+
+			lua_createtable(L, 0, 10);
+			LuaPushNamedString(L, "name", lcd->owner->GetName());
+			LuaPushNamedBool(L, "synced", synced);
+			LuaPushNamedNumber(L, "memUsage", lcd->allocState.allocedBytes / 1024.0f);
+			LuaPushNamedNumber(L, "allocRate", gcCtrl.allocRate);
+			LuaPushNamedNumber(L, "collections", gcCtrl.numCollections);
+			LuaPushNamedNumber(L, "runTime", gcCtrl.totalRunTime);
+			LuaPushNamedNumber(L, "lastRunTime", gcCtrl.lastRunTime);
+			LuaPushNamedNumber(L, "freed", gcCtrl.numBytesFreed / 1024.0f);
+			LuaPushNamedNumber(L, "poolSize", lcd->memPool->GetSlabSize() / 1024.0f);
+			LuaPushNamedNumber(L, "poolFragmentation", lcd->memPool->GetFragmentation());
+			lua_rawseti(L, -2, ++count);
+		}
+	}
+
+	return 1;
+}
+
+
 /***
  *
  * @function Spring.GetVidMemUsage
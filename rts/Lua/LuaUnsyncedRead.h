@@ -23,6 +23,7 @@ class LuaUnsyncedRead {
 		static int GetProfilerRecordNames(lua_State* L);
 
 		static int GetLuaMemUsage(lua_State* L);
+		static int GetLuaGCStats(lua_State* L);
 		static int GetVidMemUsage(lua_State* L);
 
 		static int GetDrawFrame(lua_State* L);
@@ -6,6 +6,7 @@
 
 #include "LuaVFS.h"
 #include "LuaInclude.h"
+#include "LuaBytecodeCache.h"
 #include "LuaHandle.h"
 #include "LuaHashString.h"
 #include "LuaIO.h"
@@ -173,7 +174,7 @@ int LuaVFS::Include(lua_State* L, bool synced)
 	}
 
 	tracy::LuaRemove(fileData.data());
-	if ((luaError = luaL_loadbuffer(L, fileData.c_str(), fileData.size(), fileName.c_str())) != 0) {
+	if ((luaError = LuaBytecodeCache::LoadBuffer(L, fileData, fileName)) != 0) {
 		const auto buf = fmt::format("[LuaVFS::{}(synced={})][loadbuf] file={} error={} ({}) cenv={} vfsmode={}", __func__, synced, fileName, luaError, lua_tostring(L, -1), hasCustomEnv, mode);
 		lua_pushlstring(L, buf.c_str(), buf.size());
 		lua_error(L);
@@ -60,9 +60,6 @@ void GameParticipant::Kill(const std::string& reason, const bool flush)
 	}
 
 	aiClientLinks[MAX_AIS].link.reset();
-#ifdef SYNCCHECK
-	syncResponse.clear();
-#endif
 
 	myState = (disconnected) ? DISCONNECTED : DISCONNECTING;
 }
@@ -67,10 +67,6 @@ public:
 	std::shared_ptr<netcode::CConnection> clientLink;
 	spring::unordered_map<uint8_t, ClientLinkData> aiClientLinks;
 
-	#ifdef SYNCCHECK
-	spring::unordered_map<int, unsigned int> syncResponse; // syncResponse[frameNum] = checksum
-	#endif
-
 private:
 	void CloseConnection(bool flush);
 };
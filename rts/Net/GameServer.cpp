@@ -45,6 +45,7 @@
 #include "System/TdfParser.h"
 #include "System/StringHash.h"
 #include "System/StringUtil.h"
+#include "System/Sync/SyncChecker.h"
 #include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "System/Net/Connection.h"
@@ -91,6 +92,7 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_GAMESERVER)
 
 /// frames until a synccheck will time out and a warning is given out
 static constexpr unsigned SYNCCHECK_TIMEOUT = 300;
+static_assert(CSyncResponseTable::NUM_FRAME_SLOTS > SYNCCHECK_TIMEOUT, "outstanding frames would overwrite each other");
 
 /// used to prevent msg spam
 static constexpr unsigned SYNCCHECK_MSG_TIMEOUT = 400;
@@ -168,7 +170,7 @@ void CGameServer::Initialize()
 
 	// start network
 	if (!myGameSetup->onlyLocal)
-		udpListener.reset(new netcode::UDPListener(myClientSetup->hostPort, myClientSetup->hostIP));
+		udpListener.reset(new netcode::UDPListener(myClientSetup->hostPort, myClientSetup->hostIP, globalConfig.networkRecvThread));
 
 	AddAutohostInterface(StringToLower(configHandler->GetString("AutohostIP")), configHandler->GetInt("AutohostPort"));
 	Message(spring::format(ServerStart, myClientSetup->hostPort), false);
@@ -477,6 +479,7 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 				if (targetFrameNum == -1) {
 					// not skipping
 					outstandingSyncFrames.insert(serverFrameNum);
+					syncResponses.AddFrame(serverFrameNum);
 				}
 				CheckSync();
 #endif
@@ -586,20 +589,29 @@ void CGameServer::PrivateMessage(int playerNum, const std::string& message) {
 void CGameServer::CheckSync()
 {
 #ifdef SYNCCHECK
-	std::vector< std::pair<unsigned, unsigned> > checksums; // <response checkum, #clients matching checksum>
 	std::vector<int> noSyncResponsePlayers;
+	std::vector<int> desyncGroupPlayers;
 
-	std::map<unsigned, std::vector<int> > desyncGroups; // <desync-checksum, [desynced players]>
-	std::map<int, unsigned> desyncSpecs; // <playerNum, desync-checksum>
+	std::vector< std::pair<unsigned, int> > desyncGroups; // <desync-checksum, desynced player>
+	std::vector< std::pair<int, unsigned> > desyncSpecs; // <playerNum, desync-checksum>
+
+	// players whose responses are expected (and count towards the majority)
+	std::vector<uint8_t> syncVoters(players.size(), 0);
+
+	for (const GameParticipant& p: players) {
+		syncVoters[p.id] = (p.clientLink != nullptr && p.myState != GameParticipant::State::DISCONNECTING);
+	}
+
+	noSyncResponsePlayers.reserve(players.size());
+	desyncGroups.reserve(players.size());
+	desyncSpecs.reserve(players.size());
 
 	auto outstandingSyncFrameIt = outstandingSyncFrames.begin();
 
 	while (outstandingSyncFrameIt != outstandingSyncFrames.end()) {
 		const signed outstandingSyncFrame = *outstandingSyncFrameIt;
 
-		unsigned correctChecksum = 0;
-		// maximum number of matched checksums
-		unsigned maxChecksumCount = 0;
+		uint32_t correctChecksum = 0;
 
 		bool haveCorrectChecksum = false;
 		bool completeResponseSet =  true;
@@ -607,76 +619,24 @@ void CGameServer::CheckSync()
 
 		if (HasLocalClient()) {
 			// dictatorship; all player checksums must match the local client's for this frame
-			const auto it = players[localClientNumber].syncResponse.find(outstandingSyncFrame);
-
-			if (it != players[localClientNumber].syncResponse.end()) {
-				correctChecksum = it->second;
-				haveCorrectChecksum = true;
-			}
+			haveCorrectChecksum = syncResponses.GetResponse(outstandingSyncFrame, localClientNumber, correctChecksum);
 		} else {
 			// democracy; use the checksum that most players agree on as baseline
-			checksums.clear();
-			checksums.reserve(players.size());
-
-			for (const GameParticipant& p: players) {
-				if (p.clientLink == nullptr || p.myState == GameParticipant::State::DISCONNECTING)
-					continue;
-
-				const auto pChecksumIt = p.syncResponse.find(outstandingSyncFrame);
-
-				if (pChecksumIt == p.syncResponse.end())
-					continue;
-
-				const unsigned pChecksum = pChecksumIt->second;
-				// const unsigned cChecksum = checksums[0].first;
-
-				bool checksumFound = false;
-
-				// compare player <p>'s sync-response checksum for the
-				// outstanding frame to all others we have seen so far
-				for (auto& checksumPair: checksums) {
-					const unsigned  cChecksum      = checksumPair.first;
-					      unsigned& cChecksumCount = checksumPair.second;
-
-					if (cChecksum != pChecksum)
-						continue;
-
-					checksumFound = true;
-
-					if (maxChecksumCount < (++cChecksumCount)) {
-						maxChecksumCount = cChecksumCount;
-						correctChecksum = cChecksum;
-					}
-				}
-
-				if (checksumFound)
-					continue;
-
-				// first time we have seen this checksum
-				checksums.emplace_back(pChecksum, 1);
-
-				if (maxChecksumCount == 0) {
-					maxChecksumCount = 1;
-					correctChecksum = pChecksum;
-				}
-			}
-
-			haveCorrectChecksum = (maxChecksumCount > 0);
+			haveCorrectChecksum = (syncResponses.FindMajority(outstandingSyncFrame, syncVoters, correctChecksum) > 0);
 		}
 
 
 		noSyncResponsePlayers.clear();
-		noSyncResponsePlayers.reserve(players.size());
 		desyncGroups.clear();
 		desyncSpecs.clear();
 
 		for (GameParticipant& p: players) {
-			if (p.clientLink == nullptr || p.myState == GameParticipant::State::DISCONNECTING)
+			if (syncVoters[p.id] == 0)
 				continue;
 
-			const auto pChecksumIt = p.syncResponse.find(outstandingSyncFrame);
+			uint32_t pChecksum = 0;
 
-			if (pChecksumIt == p.syncResponse.end()) {
+			if (!syncResponses.GetResponse(outstandingSyncFrame, p.id, pChecksum)) {
 				if (outstandingSyncFrame >= (serverFrameNum - static_cast<int>(SYNCCHECK_TIMEOUT)))
 					completeResponseSet = false;
 				else if (outstandingSyncFrame < p.lastFrameResponse)
@@ -685,13 +645,11 @@ void CGameServer::CheckSync()
 				continue;
 			}
 
-			const unsigned pChecksum = pChecksumIt->second;
-
 			if ((p.desynced = (haveCorrectChecksum && pChecksum != correctChecksum))) {
 				if (demoReader || !p.spectator) {
-					desyncGroups[pChecksum].push_back(p.id);
+					desyncGroups.emplace_back(pChecksum, p.id);
 				} else {
-					desyncSpecs[p.id] = pChecksum;
+					desyncSpecs.emplace_back(p.id, pChecksum);
 				}
 			}
 		}
@@ -729,6 +687,22 @@ void CGameServer::CheckSync()
 				Broadcast(CBaseNetProtocol::Get().SendSdCheckrequest(serverFrameNum));
 			#endif
 
+				// ask everyone for their per-category checksums of this frame
+				// to find out which part of the simulation diverged first
+				if (demoReader == nullptr && syncChecksumsRequest.frameNum < 0) {
+					syncChecksumsRequest.frameNum = outstandingSyncFrame;
+					syncChecksumsRequest.requestFrameNum = serverFrameNum;
+					syncChecksumsRequest.players.clear();
+					syncChecksumsRequest.responses.clear();
+
+					for (const GameParticipant& p: players) {
+						if (syncResponses.HasResponse(outstandingSyncFrame, p.id))
+							syncChecksumsRequest.players.push_back(p.id);
+					}
+
+					Broadcast(CBaseNetProtocol::Get().SendSyncChecksums(SERVER_PLAYER, outstandingSyncFrame, {}));
+				}
+
 				if (!desyncHasOccurred) {
 					if (globalConfig.dumpGameStateOnDesync) {
 						LOG("Desync detected. Requesting all clients to collect game state information.");
@@ -745,9 +719,17 @@ void CGameServer::CheckSync()
 				// For each group, output a message with list of player names in it.
 				// TODO this should be linked to the resync system so it can roundrobin
 				// the resync checksum request packets to multiple clients in the same group.
-				for (const auto& desyncGroup: desyncGroups) {
-					const std::string& playerNames = GetPlayerNames(desyncGroup.second);
-					Message(spring::format(SyncError, playerNames.c_str(), outstandingSyncFrame, desyncGroup.first, correctChecksum));
+				std::sort(desyncGroups.begin(), desyncGroups.end());
+
+				for (size_t i = 0, j = 0; i < desyncGroups.size(); i = j) {
+					desyncGroupPlayers.clear();
+
+					for (j = i; j < desyncGroups.size() && desyncGroups[j].first == desyncGroups[i].first; j++) {
+						desyncGroupPlayers.push_back(desyncGroups[j].second);
+					}
+
+					const std::string& playerNames = GetPlayerNames(desyncGroupPlayers);
+					Message(spring::format(SyncError, playerNames.c_str(), outstandingSyncFrame, desyncGroups[i].first, correctChecksum));
 				}
 
 				// send spectator desyncs as private messages to reduce spam
@@ -762,10 +744,7 @@ void CGameServer::CheckSync()
 
 		// Remove complete sets (for which all player's checksums have been received).
 		if (completeResponseSet) {
-			for (GameParticipant& p: players) {
-				if (p.myState < GameParticipant::DISCONNECTING)
-					p.syncResponse.erase(outstandingSyncFrame);
-			}
+			syncResponses.RemoveFrame(outstandingSyncFrame);
 
 			outstandingSyncFrameIt = outstandingSyncFrames.erase(outstandingSyncFrameIt);
 			continue;
@@ -774,6 +753,9 @@ void CGameServer::CheckSync()
 		++outstandingSyncFrameIt;
 	}
 
+	if (syncChecksumsRequest.frameNum >= 0 && (serverFrameNum - syncChecksumsRequest.requestFrameNum) > static_cast<int>(SYNCCHECK_TIMEOUT))
+		CheckSyncChecksums(true);
+
 #else
 
 	// Make it clear this build isn't suitable for release.
@@ -785,6 +767,88 @@ void CGameServer::CheckSync()
 }
 
 
+void CGameServer::CheckSyncChecksums(bool timedOut)
+{
+#ifdef SYNCCHECK
+	SyncChecksumsRequest& request = syncChecksumsRequest;
+
+	if (!timedOut && request.responses.size() < request.players.size())
+		return;
+
+	const auto FindResponse = [&](int playerNum) {
+		const auto pred = [&](const std::pair<int, std::vector<uint32_t>>& r) { return (r.first == playerNum); };
+		return std::find_if(request.responses.begin(), request.responses.end(), pred);
+	};
+
+	std::vector<int> respondingPlayers;
+	std::vector<int> desyncedPlayers;
+	std::vector< std::pair<uint32_t, unsigned> > checksums; // <category checksum, #clients matching checksum>
+
+	respondingPlayers.reserve(request.responses.size());
+	desyncedPlayers.reserve(request.responses.size());
+
+	for (const auto& response: request.responses) {
+		respondingPlayers.push_back(response.first);
+	}
+
+	bool anyDiverged = false;
+
+	for (unsigned category = 0; category < SYNC_CATEGORY_COUNT; category++) {
+		uint32_t correctChecksum = 0;
+		bool haveCorrectChecksum = false;
+
+		// same rules as CheckSync; local client dictates, otherwise majority vote
+		if (HasLocalClient() && FindResponse(localClientNumber) != request.responses.end()) {
+			correctChecksum = FindResponse(localClientNumber)->second[category];
+			haveCorrectChecksum = true;
+		} else {
+			unsigned maxChecksumCount = 0;
+
+			checksums.clear();
+
+			for (const auto& response: request.responses) {
+				const uint32_t rChecksum = response.second[category];
+				const auto pred = [&](const std::pair<uint32_t, unsigned>& c) { return (c.first == rChecksum); };
+				const auto iter = std::find_if(checksums.begin(), checksums.end(), pred);
+
+				unsigned& count = (iter == checksums.end())? checksums.emplace_back(rChecksum, 0).second: iter->second;
+
+				if (maxChecksumCount < (++count)) {
+					maxChecksumCount = count;
+					correctChecksum = rChecksum;
+				}
+			}
+
+			haveCorrectChecksum = (maxChecksumCount > 0);
+		}
+
+		if (!haveCorrectChecksum)
+			continue;
+
+		desyncedPlayers.clear();
+
+		for (const auto& response: request.responses) {
+			if (response.second[category] != correctChecksum)
+				desyncedPlayers.push_back(response.first);
+		}
+
+		if (desyncedPlayers.empty())
+			continue;
+
+		anyDiverged = true;
+		Message(spring::format(SyncErrorCategory, request.frameNum, GetSyncCategoryName(category), GetPlayerNames(desyncedPlayers).c_str()));
+	}
+
+	if (!anyDiverged)
+		Message(spring::format(SyncErrorNoCategory, request.frameNum, GetPlayerNames(respondingPlayers).c_str()));
+
+	request.frameNum = -1;
+	request.players.clear();
+	request.responses.clear();
+#endif
+}
+
+
 float CGameServer::GetDemoTime() const {
 	if (!gameHasStarted) return gameTime;
 	return (startTime + serverFrameNum / float(GAME_SPEED));
@@ -804,6 +868,16 @@ void CGameServer::Update()
 		// <modGameTime>
 		if (demoReader == nullptr || !HasLocalClient() || (serverFrameNum - players[localClientNumber].lastFrameResponse) < GAME_SPEED)
 			modGameTime += (tdif * internalSpeed);
+
+		// when benchmarking, hand out demo frames as fast as the local client
+		// simulates them instead of at (game-)speed; the client stays within
+		// GAME_SPEED frames of the server as it does for normal playback
+		if (demoReader != nullptr && HasLocalClient() && !myClientSetup->benchmarkFile.empty()) {
+			const int numLagFrames = serverFrameNum - players[localClientNumber].lastFrameResponse;
+
+			if (numLagFrames < GAME_SPEED)
+				modGameTime = std::max(modGameTime, demoReader->GetNextDemoReadTime() + (GAME_SPEED - numLagFrames) / float(GAME_SPEED));
+		}
 	}
 
 	if (lastPlayerInfo < (spring_gettime() - playerInfoTime)) {
@@ -1360,8 +1434,8 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 			assert(a == playerNum);
 			GameParticipant& p = players[a];
 
-			if (outstandingSyncFrames.find(frameNum) != outstandingSyncFrames.end())
-				p.syncResponse[frameNum] = checkSum;
+			// ignored unless <frameNum> is outstanding
+			syncResponses.AddResponse(frameNum, a, checkSum);
 
 			// update player's ping (if !defined(SYNCCHECK) this is done in NETMSG_KEYFRAME)
 			if (frameNum <= serverFrameNum && frameNum > p.lastFrameResponse)
@@ -1846,6 +1920,41 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 			LOG("Server broadcast game state collection request.");
 			Broadcast(packet);
 			break;
+
+		case NETMSG_SYNC_CHECKSUMS: {
+#ifdef SYNCCHECK
+			try {
+				netcode::UnpackPacket pckt(packet, 3);
+
+				uint8_t playerNum; pckt >> playerNum;
+				int32_t  frameNum; pckt >> frameNum;
+
+				std::vector<uint32_t> checksums(SYNC_CATEGORY_COUNT);
+				pckt >> checksums;
+
+				if (playerNum != a)
+					throw netcode::UnpackPacketException("Invalid player number");
+
+				SyncChecksumsRequest& request = syncChecksumsRequest;
+
+				// unsolicited or late
+				if (frameNum != request.frameNum)
+					break;
+				if (std::find(request.players.begin(), request.players.end(), a) == request.players.end())
+					break;
+
+				const auto pred = [&](const std::pair<int, std::vector<uint32_t>>& r) { return (r.first == static_cast<int>(a)); };
+
+				if (std::find_if(request.responses.begin(), request.responses.end(), pred) != request.responses.end())
+					break;
+
+				request.responses.emplace_back(a, std::move(checksums));
+				CheckSyncChecksums(false);
+			} catch (const netcode::UnpackPacketException& ex) {
+				Message(spring::format("Player %s sent invalid SyncChecksums: %s", players[a].name.c_str(), ex.what()));
+			}
+#endif
+		} break;
 		// CGameServer should never get these messages
 		//case NETMSG_GAMEID:
 		//case NETMSG_INTERNAL_SPEED:
@@ -2675,6 +2784,7 @@ void CGameServer::CreateNewFrame(bool fromServerThread, bool fixedFrameTime)
 			}
 		#ifdef SYNCCHECK
 			outstandingSyncFrames.insert(serverFrameNum);
+			syncResponses.AddFrame(serverFrameNum);
 		#endif
 		}
 	}
@@ -3012,6 +3122,12 @@ unsigned CGameServer::BindConnection(
 	}
 
 	newPlayer.Connected(clientLink, isLocal);
+#ifdef SYNCCHECK
+	// responses of a previous client in this slot do not count
+	syncResponses.ClearPlayer(newPlayerNumber);
+#endif
+	// versions matched, safe to compress from here on; the client follows suit
+	newPlayer.clientLink->EnableCompression();
 	newPlayer.SendData(std::shared_ptr<const RawPacket>(myGameData->Pack()));
 	newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
 
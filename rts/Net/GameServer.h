@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "Game/GameData.h"
+#include "Net/SyncResponseTable.h"
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/TeamBase.h"
 #include "System/float3.h"
@@ -161,6 +162,7 @@ private:
 	void Update();
 	void ProcessPacket(const unsigned playerNum, std::shared_ptr<const netcode::RawPacket> packet);
 	void CheckSync();
+	void CheckSyncChecksums(bool timedOut);
 	void HandleConnectionAttempts();
 	void ServerReadNet();
 
@@ -226,6 +228,19 @@ private:
 	/////////////////// sync stuff ///////////////////
 #ifdef SYNCCHECK
 	std::set<int> outstandingSyncFrames;
+	/// sync-response checksums of every player for <outstandingSyncFrames>
+	CSyncResponseTable syncResponses = {MAX_PLAYERS};
+
+	/// per-category checksums requested from clients after a desync
+	struct SyncChecksumsRequest {
+		int frameNum = -1;
+		int requestFrameNum = -1;
+
+		std::vector<int> players;
+		std::vector< std::pair<int, std::vector<uint32_t>> > responses;
+	};
+
+	SyncChecksumsRequest syncChecksumsRequest;
 #endif
 
 	/////////////////// game status variables ///////////////////
@@ -10,6 +10,7 @@
 #include "Game/ClientData.h"
 #include "Game/CommandMessage.h"
 #include "Game/GameSetup.h"
+#include "Game/BenchmarkRecorder.h"
 #include "Game/GlobalUnsynced.h"
 #include "Game/SelectedUnitsHandler.h"
 #include "Game/ChatMessage.h"
@@ -621,6 +622,8 @@ void CGame::ClientReadNet()
 				ASSERT_SYNCED(gs->frameNum);
 				ASSERT_SYNCED(CSyncChecker::GetChecksum());
 				clientNet->Send(CBaseNetProtocol::Get().SendSyncResponse(gu->myPlayerNum, gs->frameNum, CSyncChecker::GetChecksum()));
+				// kept around in case the server asks which category diverged
+				CSyncChecker::StoreFrameChecksums(gs->frameNum);
 
 				// buffer all checksums, so we can check sync later between demo & local
 				if (haveServerDemo)
@@ -654,6 +657,10 @@ void CGame::ClientReadNet()
 					// frame in the original game (in case of a demo)
 					if (playerNum == gu->myPlayerNum)
 						break;
+
+					if (benchmarkRecorder != nullptr)
+						benchmarkRecorder->AddSyncCheck();
+
 					if (checkSum == ourCheckSum)
 						break;
 
@@ -664,6 +671,9 @@ void CGame::ClientReadNet()
 					const char* fmtStr = "[DESYNC WARNING] checksum %x from demo %s %d (%s) does not match our checksum %x for frame-number %d";
 
 					LOG_L(L_ERROR, fmtStr, checkSum, pType, playerNum, pName, ourCheckSum, frameNum);
+
+					if (benchmarkRecorder != nullptr)
+						benchmarkRecorder->AddDesync(frameNum);
 				}
 #endif
 			} break;
@@ -1574,6 +1584,26 @@ void CGame::ClientReadNet()
 				break;
 			}
 
+			case NETMSG_SYNC_CHECKSUMS: {
+#ifdef SYNCCHECK
+				try {
+					netcode::UnpackPacket pckt(packet, 3);
+
+					uint8_t playerNum; pckt >> playerNum;
+					int32_t  frameNum; pckt >> frameNum;
+
+					std::vector<uint32_t> checksums;
+
+					// ignore anything but requests, and frames that have left our history already
+					if (playerNum == SERVER_PLAYER && CSyncChecker::GetFrameChecksums(frameNum, checksums))
+						clientNet->Send(CBaseNetProtocol::Get().SendSyncChecksums(gu->myPlayerNum, frameNum, checksums));
+				} catch (const netcode::UnpackPacketException& ex) {
+					LOG_L(L_ERROR, "[Game::%s][NETMSG_SYNC_CHECKSUMS] exception \"%s\"", __func__, ex.what());
+				}
+#endif
+				AddTraffic(-1, packetCode, dataLength);
+			} break;
+
 			default: {
 #ifdef SYNCDEBUG
 				if (!CSyncDebugger::GetInstance()->ClientReceived(inbuf))
@@ -611,6 +611,17 @@ PacketType CBaseNetProtocol::SendGameStateDump()
 	return PacketType(packet);
 }
 
+PacketType CBaseNetProtocol::SendSyncChecksums(uint8_t playerNum, int32_t frameNum, const std::vector<uint32_t>& checksums)
+{
+	const uint32_t payloadSize = sizeof(playerNum) + sizeof(frameNum) + (checksums.size() * sizeof(uint32_t));
+	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
+	const uint32_t packetSize = headerSize + payloadSize;
+
+	PackPacket* packet = new PackPacket(packetSize, NETMSG_SYNC_CHECKSUMS);
+	*packet << static_cast<uint16_t>(packetSize) << playerNum << frameNum << checksums;
+	return PacketType(packet);
+}
+
 CBaseNetProtocol::CBaseNetProtocol()
 {
 	netcode::ProtocolDef* proto = netcode::ProtocolDef::GetInstance();
@@ -681,5 +692,6 @@ CBaseNetProtocol::CBaseNetProtocol()
 #endif // SYNCDEBUG
 
 	proto->AddType(NETMSG_GAMESTATE_DUMP, 1);
+	proto->AddType(NETMSG_SYNC_CHECKSUMS, -2);
 }
 
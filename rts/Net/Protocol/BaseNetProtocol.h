@@ -120,6 +120,9 @@ public:
 
 	PacketType SendGameStateDump();
 
+	/// sent by the server with empty <checksums> to request the per-category values for <frameNum>
+	PacketType SendSyncChecksums(uint8_t playerNum, int32_t frameNum, const std::vector<uint32_t>& checksums);
+
 private:
 	CBaseNetProtocol();
 
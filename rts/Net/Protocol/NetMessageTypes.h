@@ -67,6 +67,7 @@ enum NETMSG {
 #endif // SYNCDEBUG
 
 	NETMSG_GAMESTATE_DUMP	= 46, // no arguments
+	NETMSG_SYNC_CHECKSUMS   = 47, // uint16_t messageSize, uint8_t playerNum, int32_t frameNum, std::vector<uint32_t> checksums (one per SyncCategory, none if sent by the server as request)
 
 	NETMSG_LOGMSG           = 49, // uint8_t playerNum, uint8_t logMsgLvl, std::string strData
 	NETMSG_LUAMSG           = 50, // /* uint16_t messageSize */, uint8_t playerNum, uint16_t script, uint8_t mode, std::vector<uint8_t> rawData
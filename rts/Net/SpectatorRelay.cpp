@@ -0,0 +1,266 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "SpectatorRelay.h"
+#include "Game/GameVersion.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/GlobalConfig.h"
+#include "System/SpringFormat.h"
+#include "System/Log/ILog.h"
+#include "System/Net/Connection.h"
+#include "System/Net/UDPConnection.h"
+#include "System/Net/UDPListener.h"
+#include "System/Net/UnpackPacket.h"
+#include "System/Platform/Misc.h"
+
+
+CSpectatorRelay::CSpectatorRelay(const Settings& _settings): settings(_settings)
+{
+	// log the whole game; a cast rarely lasts long enough for this to matter
+	packetLog.reserve(1 << 16);
+	spectators.reserve(256);
+
+	upstream = std::make_shared<netcode::UDPConnection>(0, settings.hostIP, settings.hostPort);
+	upstream->Unmute();
+	upstream->SendData(CBaseNetProtocol::Get().SendAttemptConnect(settings.name, settings.passwd, SpringVersion::GetSync(), Platform::GetPlatformStr(), globalConfig.networkLossFactor));
+	upstream->Flush(true);
+
+	listener = std::make_unique<netcode::UDPListener>(settings.relayPort);
+	listener->SetAcceptingConnections(true);
+
+	LOG("[SpectatorRelay::%s] relaying %s:%d to port %d (delay %ds)", __func__, settings.hostIP.c_str(), settings.hostPort, settings.relayPort, settings.delay);
+}
+
+CSpectatorRelay::~CSpectatorRelay()
+{
+	for (Spectator& spec: spectators) {
+		spec.link->Close(true);
+	}
+
+	upstream->Close(true);
+}
+
+
+void CSpectatorRelay::Update()
+{
+	UpdateUpstream();
+
+	listener->Update();
+
+	HandleConnectionAttempts();
+	UpdateDownstream();
+}
+
+
+void CSpectatorRelay::UpdateUpstream()
+{
+	upstream->Update();
+
+	if (upstreamClosed)
+		return;
+
+	std::shared_ptr<const netcode::RawPacket> packet;
+
+	while ((packet = upstream->GetData()) != nullptr) {
+		if (packet->length == 0)
+			continue;
+
+		switch (packet->data[0]) {
+			case NETMSG_REJECT_CONNECT: {
+				try {
+					netcode::UnpackPacket pckt(packet, 3);
+					std::string reason;
+					pckt >> reason;
+
+					Finish("server rejected the relay: " + reason);
+				} catch (const netcode::UnpackPacketException&) {
+					Finish("server rejected the relay");
+				}
+			} return;
+
+			case NETMSG_QUIT: {
+				upstreamClosed = true;
+			} break;
+
+			default: {
+				if (!connected)
+					LOG("[SpectatorRelay::%s] connected to server", __func__);
+
+				connected = true;
+			} break;
+		}
+
+		packetLog.push_back({packet, spring_gettime()});
+
+		if (upstreamClosed)
+			return;
+	}
+
+	if (!upstream->CheckTimeout(0, !connected))
+		return;
+
+	LOG_L(L_WARNING, "[SpectatorRelay::%s] lost connection to server", __func__);
+
+	// let spectators know once they have caught up
+	packetLog.push_back({CBaseNetProtocol::Get().SendQuit("relay lost connection to server"), spring_gettime()});
+	upstreamClosed = true;
+}
+
+void CSpectatorRelay::UpdateDownstream()
+{
+	const spring_time curTime = spring_gettime();
+	const spring_time minTime = curTime - spring_secs(settings.delay);
+
+	while (numReleasedPackets < packetLog.size() && packetLog[numReleasedPackets].recvTime <= minTime) {
+		numReleasedPackets += 1;
+	}
+
+	for (size_t i = 0; i < spectators.size(); ) {
+		Spectator& spec = spectators[i];
+
+		// packets are shared between all links, not copied
+		while (spec.nextPacket < numReleasedPackets) {
+			spec.link->SendData(packetLog[spec.nextPacket++].packet);
+		}
+
+		bool quit = false;
+
+		// downstream clients are read-only; only answer their pings
+		std::shared_ptr<const netcode::RawPacket> packet;
+
+		while (!quit && (packet = spec.link->GetData()) != nullptr) {
+			if (packet->length == 0)
+				continue;
+
+			switch (packet->data[0]) {
+				case NETMSG_PING: {
+					// limit to 50 pings per second, same as the server
+					if (packet->length < 7 || spring_diffmsecs(curTime, spec.lastPing) < 20)
+						break;
+
+					spec.link->SendData(CBaseNetProtocol::Get().SendPing(packet->data[1], packet->data[2], *(reinterpret_cast<const float*>(&packet->data[3]))));
+					spec.lastPing = curTime;
+				} break;
+				case NETMSG_QUIT: {
+					quit = true;
+				} break;
+				default: {
+				} break;
+			}
+		}
+
+		if (quit || spec.link->CheckTimeout()) {
+			LOG("[SpectatorRelay::%s] %s (%s) %s", __func__, spec.name.c_str(), spec.link->GetFullAddress().c_str(), quit? "left": "timed out");
+
+			spec.link->Close(!quit);
+			spectators[i] = std::move(spectators.back());
+			spectators.pop_back();
+			continue;
+		}
+
+		i += 1;
+	}
+
+	if (!upstreamClosed || spring_istime(quitTime))
+		return;
+	if (numReleasedPackets < packetLog.size())
+		return;
+
+	// give the final packets a moment to get through
+	LOG("[SpectatorRelay::%s] server closed the game, relay shutting down", __func__);
+	quitTime = curTime + spring_secs(2);
+}
+
+
+void CSpectatorRelay::HandleConnectionAttempts()
+{
+	while (listener->HasIncomingConnections()) {
+		std::shared_ptr<netcode::UDPConnection> prev = listener->PreviewConnection().lock();
+		std::shared_ptr<const netcode::RawPacket> packet = prev->GetData();
+
+		if (packet == nullptr) {
+			listener->RejectConnection();
+			continue;
+		}
+
+		try {
+			if (packet->length < 3 || packet->data[0] != NETMSG_ATTEMPTCONNECT)
+				throw netcode::UnpackPacketException("Invalid message ID");
+
+			netcode::UnpackPacket msg(packet, 3);
+			std::string name;
+			std::string passwd;
+			std::string version;
+			std::string platform;
+			uint8_t reconnect;
+			uint8_t netloss;
+			uint16_t netversion;
+			msg >> netversion;
+			msg >> name;
+			msg >> passwd;
+			msg >> version;
+			msg >> platform;
+			msg >> reconnect;
+			msg >> netloss;
+
+			if (netversion != NETWORK_VERSION)
+				throw netcode::UnpackPacketException(spring::format("Wrong network version: received %d, required %d", (int)netversion, (int)NETWORK_VERSION));
+			if (upstreamClosed)
+				throw netcode::UnpackPacketException("Relay is shutting down");
+
+			AddSpectator(listener->AcceptConnection(), name, reconnect);
+		} catch (const netcode::UnpackPacketException& ex) {
+			LOG_L(L_WARNING, "[SpectatorRelay::%s] rejected connection from %s: %s", __func__, prev->GetFullAddress().c_str(), ex.what());
+
+			prev->Unmute();
+			prev->SendData(CBaseNetProtocol::Get().SendRejectConnect(ex.what()));
+			prev->Flush(true);
+
+			listener->RejectConnection();
+		}
+	}
+}
+
+void CSpectatorRelay::AddSpectator(std::shared_ptr<netcode::UDPConnection> link, const std::string& name, bool reconnect)
+{
+	if (reconnect) {
+		const auto pred = [&](const Spectator& s) { return (s.name == name && s.link->CanReconnect()); };
+		const auto iter = std::find_if(spectators.begin(), spectators.end(), pred);
+
+		// a reconnecting client is midway through the stream, can not restart it
+		if (iter == spectators.end()) {
+			link->Unmute();
+			link->SendData(CBaseNetProtocol::Get().SendRejectConnect("User can not reconnect"));
+			link->Flush(true);
+			return;
+		}
+
+		iter->link->ReconnectTo(*link);
+		listener->UpdateConnections();
+
+		LOG("[SpectatorRelay::%s] %s reconnected from %s", __func__, name.c_str(), iter->link->GetFullAddress().c_str());
+		return;
+	}
+
+	link->Unmute();
+	link->EnableCompression();
+
+	spectators.push_back({link, name, 0, spring_notime});
+
+	LOG("[SpectatorRelay::%s] %s joined from %s (" _STPF_ " spectators)", __func__, name.c_str(), link->GetFullAddress().c_str(), spectators.size());
+}
+
+
+void CSpectatorRelay::Finish(const std::string& reason)
+{
+	LOG_L(L_WARNING, "[SpectatorRelay::%s] %s", __func__, reason.c_str());
+
+	for (Spectator& spec: spectators) {
+		spec.link->SendData(CBaseNetProtocol::Get().SendQuit(reason));
+		spec.link->Flush(true);
+	}
+
+	upstreamClosed = true;
+	quitTime = spring_gettime();
+}
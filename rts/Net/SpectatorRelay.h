@@ -0,0 +1,101 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _SPECTATOR_RELAY_H
+#define _SPECTATOR_RELAY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "System/Misc/NonCopyable.h"
+#include "System/Misc/SpringTime.h"
+
+namespace netcode {
+	class RawPacket;
+	class UDPConnection;
+	class UDPListener;
+}
+
+/**
+ * @brief Fans the game stream of a server out to many spectators
+ *
+ * The relay joins a (primary) server as a single spectator and forwards every
+ * packet it receives, unaltered, to each spectator connected to its own port.
+ * Packets are held back for <delay> before they are forwarded, which allows
+ * running casts with a delay; late joiners get the full history replayed just
+ * like they would from the server itself.
+ *
+ * The relay is read-only: nothing downstream clients send is passed upstream,
+ * and since it does not simulate it never reports frame progress to the
+ * server. All downstream clients share the player number the server assigned
+ * to the relay.
+ */
+class CSpectatorRelay : spring::noncopyable
+{
+public:
+	struct Settings {
+		std::string hostIP;
+		int hostPort = 8452;
+
+		/// local port to accept spectators on
+		int relayPort = 8453;
+		/// seconds the forwarded stream lags behind the server
+		int delay = 0;
+
+		/// credentials of the relay's spectator slot on the server
+		std::string name = "relay";
+		std::string passwd;
+	};
+
+public:
+	CSpectatorRelay(const Settings& settings);
+	~CSpectatorRelay();
+
+	/// receives, forwards and flushes; call this frequently
+	void Update();
+
+	bool HasFinished() const { return (spring_istime(quitTime) && spring_gettime() >= quitTime); }
+
+private:
+	struct LoggedPacket {
+		std::shared_ptr<const netcode::RawPacket> packet;
+		spring_time recvTime;
+	};
+
+	struct Spectator {
+		std::shared_ptr<netcode::UDPConnection> link;
+		std::string name;
+
+		/// index of the next packet in <packetLog> to forward
+		size_t nextPacket = 0;
+		spring_time lastPing;
+	};
+
+	void UpdateUpstream();
+	void UpdateDownstream();
+
+	void HandleConnectionAttempts();
+	void AddSpectator(std::shared_ptr<netcode::UDPConnection> link, const std::string& name, bool reconnect);
+
+	void Finish(const std::string& reason);
+
+private:
+	Settings settings;
+
+	std::shared_ptr<netcode::UDPConnection> upstream;
+	std::unique_ptr<netcode::UDPListener> listener;
+
+	std::vector<Spectator> spectators;
+
+	/// everything received from the server, in order
+	std::vector<LoggedPacket> packetLog;
+	/// number of <packetLog> entries older than <delay>
+	size_t numReleasedPackets = 0;
+
+	bool connected = false;
+	bool upstreamClosed = false;
+
+	spring_time quitTime = spring_notime;
+};
+
+#endif // _SPECTATOR_RELAY_H
@@ -0,0 +1,140 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _SYNC_RESPONSE_TABLE_H
+#define _SYNC_RESPONSE_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Sync-response checksums of all players for the outstanding frames
+ *
+ * Flat ring buffer indexed by (frame % NUM_FRAME_SLOTS, player), a slot gets
+ * reused once its frame was removed or NUM_FRAME_SLOTS newer frames have been
+ * added. Only responses for frames added through AddFrame are stored.
+ */
+class CSyncResponseTable
+{
+public:
+	/// must exceed the server's sync-check timeout (in frames)
+	static constexpr int NUM_FRAME_SLOTS = 512;
+
+	CSyncResponseTable(int numPlayers = 0) { Init(numPlayers); }
+
+	void Init(int _numPlayers) {
+		numPlayers = _numPlayers;
+
+		slotFrames.assign(NUM_FRAME_SLOTS, -1);
+		checksums.assign(NUM_FRAME_SLOTS * numPlayers, 0);
+		responded.assign(NUM_FRAME_SLOTS * numPlayers, 0);
+	}
+
+	void AddFrame(int frameNum) {
+		const int slot = GetSlot(frameNum);
+
+		slotFrames[slot] = frameNum;
+		std::fill_n(responded.begin() + slot * numPlayers, numPlayers, 0);
+	}
+	void RemoveFrame(int frameNum) {
+		if (HasFrame(frameNum))
+			slotFrames[GetSlot(frameNum)] = -1;
+	}
+	bool HasFrame(int frameNum) const { return (frameNum >= 0 && slotFrames[GetSlot(frameNum)] == frameNum); }
+
+	/// @return false if <frameNum> is not (or no longer) outstanding
+	bool AddResponse(int frameNum, int playerNum, std::uint32_t checksum) {
+		if (!HasFrame(frameNum) || playerNum < 0 || playerNum >= numPlayers)
+			return false;
+
+		const size_t idx = GetSlot(frameNum) * numPlayers + playerNum;
+
+		checksums[idx] = checksum;
+		responded[idx] = 1;
+		return true;
+	}
+
+	bool GetResponse(int frameNum, int playerNum, std::uint32_t& checksum) const {
+		if (!HasResponse(frameNum, playerNum))
+			return false;
+
+		checksum = checksums[GetSlot(frameNum) * numPlayers + playerNum];
+		return true;
+	}
+	bool HasResponse(int frameNum, int playerNum) const {
+		if (!HasFrame(frameNum) || playerNum < 0 || playerNum >= numPlayers)
+			return false;
+
+		return (responded[GetSlot(frameNum) * numPlayers + playerNum] != 0);
+	}
+
+	/// forget all responses of <playerNum>, e.g. when a new client takes its place
+	void ClearPlayer(int playerNum) {
+		if (playerNum < 0 || playerNum >= numPlayers)
+			return;
+
+		for (int slot = 0; slot < NUM_FRAME_SLOTS; slot++) {
+			responded[slot * numPlayers + playerNum] = 0;
+		}
+	}
+
+	/**
+	 * @brief majority vote over the responses for <frameNum>
+	 * @param voters non-zero for each player whose response counts
+	 * @return number of votes for <checksum>, 0 if no voter responded
+	 *
+	 * Ties are won by the smallest checksum.
+	 */
+	unsigned FindMajority(int frameNum, const std::vector<std::uint8_t>& voters, std::uint32_t& checksum) {
+		if (!HasFrame(frameNum))
+			return 0;
+
+		const size_t base = GetSlot(frameNum) * numPlayers;
+		const size_t numVoters = std::min(voters.size(), size_t(numPlayers));
+
+		votes.clear();
+
+		for (size_t i = 0; i < numVoters; i++) {
+			if (voters[i] != 0 && responded[base + i] != 0)
+				votes.push_back(checksums[base + i]);
+		}
+
+		if (votes.empty())
+			return 0;
+
+		// equal checksums become runs, the longest run wins
+		std::sort(votes.begin(), votes.end());
+
+		unsigned maxCount = 0;
+
+		for (size_t i = 0, j = 0; i < votes.size(); i = j) {
+			for (j = i + 1; j < votes.size() && votes[j] == votes[i]; j++) {
+			}
+
+			if ((j - i) <= maxCount)
+				continue;
+
+			maxCount = j - i;
+			checksum = votes[i];
+		}
+
+		return maxCount;
+	}
+
+private:
+	static int GetSlot(int frameNum) { return (frameNum & (NUM_FRAME_SLOTS - 1)); }
+
+private:
+	int numPlayers = 0;
+
+	/// frame stored in each slot, -1 if unused
+	std::vector<int> slotFrames;
+
+	/// [slot * numPlayers + player]
+	std::vector<std::uint32_t> checksums;
+	std::vector<std::uint8_t> responded;
+
+	std::vector<std::uint32_t> votes;
+};
+
+#endif // _SYNC_RESPONSE_TABLE_H
@@ -0,0 +1,160 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "AirUnitHash.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Units/Unit.h"
+#include "Sim/Units/UnitDef.h"
+#include "System/SpringMath.h"
+
+
+CAirUnitHash airUnitHash;
+
+
+void CAirUnitHash::Init(int2 mapDims)
+{
+	numCells.x = std::max(1, (mapDims.x * SQUARE_SIZE + CELL_SIZE - 1) / CELL_SIZE);
+	numCells.y = std::max(1, (mapDims.y * SQUARE_SIZE + CELL_SIZE - 1) / CELL_SIZE);
+
+	cellOffsets.clear();
+	cellOffsets.resize(numCells.x * numCells.y + 1, 0);
+	cellCursors.clear();
+	cellCursors.resize(numCells.x * numCells.y, 0);
+
+	// reserve for a reasonably large air-force up front
+	cellUnits.reserve(1024);
+	cellHeights.reserve(1024);
+	unitCells.reserve(1024);
+	airUnits.reserve(1024);
+	queryUnits.reserve(256);
+}
+
+void CAirUnitHash::Kill()
+{
+	// reuse buffers when reloading
+	std::fill(cellOffsets.begin(), cellOffsets.end(), 0);
+
+	cellUnits.clear();
+	cellHeights.clear();
+	unitCells.clear();
+	airUnits.clear();
+	queryUnits.clear();
+
+	maxUnitRadius = 0.0f;
+	maxUnitSpeed = 0.0f;
+}
+
+
+int CAirUnitHash::GetCellIdx(const float3& pos) const
+{
+	const int cx = std::clamp(int(pos.x / CELL_SIZE), 0, numCells.x - 1);
+	const int cz = std::clamp(int(pos.z / CELL_SIZE), 0, numCells.y - 1);
+
+	return (cz * numCells.x + cx);
+}
+
+
+void CAirUnitHash::Update(const std::vector<CUnit*>& activeUnits)
+{
+	airUnits.clear();
+	unitCells.clear();
+
+	std::fill(cellOffsets.begin(), cellOffsets.end(), 0);
+
+	maxUnitRadius = 0.0f;
+	maxUnitSpeed = 0.0f;
+
+	// pass 1: count aircraft per cell
+	for (CUnit* unit: activeUnits) {
+		if (!unit->unitDef->canfly)
+			continue;
+
+		const int cellIdx = GetCellIdx(unit->pos);
+
+		airUnits.push_back(unit);
+		unitCells.push_back(cellIdx);
+
+		cellOffsets[cellIdx + 1] += 1;
+
+		maxUnitRadius = std::max(maxUnitRadius, unit->radius);
+		maxUnitSpeed = std::max(maxUnitSpeed, unit->speed.w);
+	}
+
+	for (size_t i = 1; i < cellOffsets.size(); i++) {
+		cellOffsets[i] += cellOffsets[i - 1];
+	}
+
+	// pass 2: scatter into cells (counting sort, stable w.r.t. activeUnits order)
+	cellUnits.resize(airUnits.size());
+	cellHeights.resize(airUnits.size());
+
+	std::copy(cellOffsets.begin(), cellOffsets.end() - 1, cellCursors.begin());
+
+	for (size_t i = 0; i < airUnits.size(); i++) {
+		cellUnits[cellCursors[unitCells[i]]++] = airUnits[i];
+	}
+
+	// pass 3: order each cell by altitude; ties are broken by id so
+	// query results do not depend on anything but synced state
+	const auto cmp = [](const CUnit* a, const CUnit* b) {
+		if (a->pos.y != b->pos.y)
+			return (a->pos.y < b->pos.y);
+
+		return (a->id < b->id);
+	};
+
+	for (size_t i = 0, n = cellOffsets.size() - 1; i < n; i++) {
+		const int beg = cellOffsets[i    ];
+		const int end = cellOffsets[i + 1];
+
+		if ((end - beg) > 1)
+			std::sort(cellUnits.begin() + beg, cellUnits.begin() + end, cmp);
+	}
+
+	for (size_t i = 0; i < cellUnits.size(); i++) {
+		cellHeights[i] = cellUnits[i]->pos.y;
+	}
+}
+
+
+const std::vector<CUnit*>& CAirUnitHash::GetUnitsExact(const float3& pos, float radius)
+{
+	queryUnits.clear();
+
+	if (cellUnits.empty())
+		return queryUnits;
+
+	// units can have moved by (at most about) one frame's worth of
+	// speed since the hash was built, pad the cell and altitude
+	// ranges accordingly; the exact test below uses live positions
+	const float pad = radius + maxUnitRadius + maxUnitSpeed * 2.0f;
+
+	const int cx0 = std::clamp(int((pos.x - pad) / CELL_SIZE), 0, numCells.x - 1);
+	const int cx1 = std::clamp(int((pos.x + pad) / CELL_SIZE), 0, numCells.x - 1);
+	const int cz0 = std::clamp(int((pos.z - pad) / CELL_SIZE), 0, numCells.y - 1);
+	const int cz1 = std::clamp(int((pos.z + pad) / CELL_SIZE), 0, numCells.y - 1);
+
+	const float minHeight = pos.y - pad;
+	const float maxHeight = pos.y + pad;
+
+	for (int cz = cz0; cz <= cz1; cz++) {
+		for (int cx = cx0; cx <= cx1; cx++) {
+			const int cellIdx = cz * numCells.x + cx;
+
+			const auto heightsBeg = cellHeights.begin() + cellOffsets[cellIdx    ];
+			const auto heightsEnd = cellHeights.begin() + cellOffsets[cellIdx + 1];
+
+			for (auto it = std::lower_bound(heightsBeg, heightsEnd, minHeight); it != heightsEnd && *it <= maxHeight; ++it) {
+				CUnit* unit = cellUnits[it - cellHeights.begin()];
+
+				if (pos.SqDistance(unit->pos) >= Square(radius + unit->radius))
+					continue;
+
+				queryUnits.push_back(unit);
+			}
+		}
+	}
+
+	return queryUnits;
+}
@@ -0,0 +1,70 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef AIR_UNIT_HASH_H
+#define AIR_UNIT_HASH_H
+
+#include <vector>
+
+#include "System/Misc/NonCopyable.h"
+#include "System/float3.h"
+#include "System/type2.h"
+
+class CUnit;
+
+/**
+ * Spatial hash that only holds aircraft (units whose def has canfly set),
+ * used by AAirMoveType for neighbour queries instead of the QuadField which
+ * would also return every ground unit below.
+ *
+ * Units are bucketed into coarse xz-cells and sorted by altitude inside each
+ * cell, so a query only touches the aircraft inside its vertical extent. The
+ * hash is rebuilt once per frame (before move-types are updated) and is only
+ * valid during CUnitHandler::UpdateUnitMoveTypes; it is not serialized since
+ * it can always be reconstructed from the active units.
+ */
+class CAirUnitHash : spring::noncopyable
+{
+public:
+	static constexpr int CELL_SIZE = 256;
+
+	void Init(int2 mapDims);
+	void Kill();
+
+	void Update(const std::vector<CUnit*>& activeUnits);
+
+	/**
+	 * Returns all aircraft within @c radius of @c pos (spherical),
+	 * taking the radius of each unit into account like
+	 * CQuadField::GetUnitsExact. The returned vector is reused by
+	 * the next query.
+	 */
+	const std::vector<CUnit*>& GetUnitsExact(const float3& pos, float radius);
+
+	size_t GetNumUnits() const { return cellUnits.size(); }
+
+private:
+	int GetCellIdx(const float3& pos) const;
+
+private:
+	int2 numCells;
+
+	/// CSR layout: units of cell i are cellUnits[cellOffsets[i] .. cellOffsets[i + 1]]
+	std::vector<int> cellOffsets;
+	/// units sorted by cell and altitude, heights[i] is cellUnits[i]->pos.y at build time
+	std::vector<CUnit*> cellUnits;
+	std::vector<float> cellHeights;
+
+	std::vector<int> cellCursors;
+	std::vector<int> unitCells;
+	std::vector<CUnit*> airUnits;
+	std::vector<CUnit*> queryUnits;
+
+	/// largest radius and speed of any hashed unit, used to pad queries
+	/// since units keep moving after the hash was built this frame
+	float maxUnitRadius = 0.0f;
+	float maxUnitSpeed = 0.0f;
+};
+
+extern CAirUnitHash airUnitHash;
+
+#endif /* AIR_UNIT_HASH_H */
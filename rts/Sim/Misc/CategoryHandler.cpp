@@ -39,7 +39,9 @@ unsigned int CCategoryHandler::GetCategory(std::string name)
 	if (name.empty())
 		return cat;
 
-	if (categories.find(name) == categories.end()) {
+	const auto it = categories.find(name);
+
+	if (it == categories.end()) {
 		// this category is yet unknown
 		if (firstUnused >= CCategoryHandler::GetMaxCategories()) {
 			// skip this category
@@ -55,7 +57,7 @@ unsigned int CCategoryHandler::GetCategory(std::string name)
 		firstUnused++;
 	} else {
 		// this category is already known
-		cat = categories[name];
+		cat = it->second;
 	}
 
 	return cat;
@@ -8,7 +8,7 @@
 #include "Map/MapInfo.h"
 #include "Rendering/Env/Particles/Classes/SmokeProjectile.h"
 #include "Sim/Ecs/Registry.h"
-#include "Sim/Misc/QuadField.h"
+#include "Sim/Misc/AirUnitHash.h"
 #include "Sim/Misc/SmoothHeightMesh.h"
 #include "Sim/Projectiles/ExplosionGenerator.h"
 #include "Sim/Projectiles/ProjectileMemPool.h"
@@ -236,8 +236,9 @@ void AAirMoveType::CheckForCollision()
 
 	float dist = 200.0f;
 
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, pos + forward * 121.0f, dist);
+	// only other aircraft are relevant here, ground units below
+	// are handled by HandleCollisions through the QuadField
+	const std::vector<CUnit*>& airUnits = airUnitHash.GetUnitsExact(pos + forward * 121.0f, dist);
 
 	if (lastCollidee != nullptr) {
 		DeleteDeathDependence(lastCollidee, DEPENDENCE_LASTCOLWARN);
@@ -247,8 +248,8 @@ void AAirMoveType::CheckForCollision()
 	}
 
 	// find closest potential collidee
-	for (CUnit* unit: *qfQuery.units) {
-		if (unit == owner || !unit->unitDef->canfly)
+	for (CUnit* unit: airUnits) {
+		if (unit == owner)
 			continue;
 
 		const SyncedFloat3& op = unit->midPos;
@@ -275,7 +276,7 @@ void AAirMoveType::CheckForCollision()
 		return;
 	}
 
-	for (CUnit* u: *qfQuery.units) {
+	for (CUnit* u: airUnits) {
 		if (u == owner)
 			continue;
 
@@ -31,7 +31,6 @@
 #include "System/SafeUtil.h"
 #include "System/StringUtil.h"
 #include "System/creg/STL_Set.h"
-#include "System/creg/STL_Deque.h"
 #include <assert.h>
 
 // number of SlowUpdate calls that a target (unit) must
@@ -3,10 +3,10 @@
 #ifndef _COMMAND_QUEUE_H
 #define _COMMAND_QUEUE_H
 
-#include <deque>
 #include "Command.h"
+#include "System/RingDeque.h"
 
-/// A wrapper class for std::deque<Command> to keep track of commands
+/// A wrapper class for spring::RingDeque<Command> to keep track of commands
 class CCommandQueue {
 
 	friend class CCommandAI;
@@ -28,7 +28,7 @@ class CCommandQueue {
 		/// limit to a float's integer range
 		static const int maxTagValue = (1 << 24); // 16777216
 
-		typedef std::deque<Command> basis;
+		typedef spring::RingDeque<Command> basis;
 
 		typedef basis::size_type              size_type;
 		typedef basis::iterator               iterator;
@@ -98,7 +98,7 @@ class CCommandQueue {
 		inline void SetQueueType(QueueType type) { queueType = type; }
 
 	private:
-		std::deque<Command> queue;
+		basis queue;
 		QueueType queueType;
 		int tagCounter;
 };
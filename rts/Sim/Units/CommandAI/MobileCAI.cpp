@@ -542,11 +542,14 @@ void CMobileCAI::ExecuteFight(Command& c)
 		CUnit* enemy = CGameHelper::GetClosestValidTarget(curPosOnLine, searchRadius, owner->allyteam, this);
 
 		if (enemy != nullptr) {
+			// PushOrUpdateReturnFight can grow the queue and invalidate <c>
+			const unsigned char cmdOpts = c.GetOpts();
+
 			PushOrUpdateReturnFight();
 
 			// make the attack-command inherit <c>'s options
 			// NOTE: see AirCAI::ExecuteFight why we do not set INTERNAL_ORDER
-			commandQue.push_front(Command(CMD_ATTACK, c.GetOpts(), enemy->id));
+			commandQue.push_front(Command(CMD_ATTACK, cmdOpts, enemy->id));
 
 			inCommand = false;
 			tempOrder = true;
@@ -639,9 +639,16 @@ void CUnit::Update()
 {
 	ASSERT_SYNCED(pos);
 
-	UpdatePhysicalState(0.1f);
+	// none if already dead
+	UpdateTransportees();
+}
+
+void CUnit::UpdateLocalMt()
+{
+	// base-class version, the state-change events are
+	// sent afterwards from a serial stage by UnitHandler
+	CSolidObject::UpdatePhysicalState(0.1f);
 	UpdatePosErrorParams(true, false);
-	UpdateTransportees(); // none if already dead
 
 	if (beingBuilt)
 		return;
@@ -1759,11 +1766,17 @@ void CUnit::DependentDied(CObject* o)
 
 void CUnit::UpdatePhysicalState(float eps)
 {
-	const bool inAir      = IsInAir();
-	const bool inWater    = IsInWater();
-	const bool underWater = IsUnderWater();
+	const unsigned int ps = physicalState;
 
 	CSolidObject::UpdatePhysicalState(eps);
+	PhysicalStateChanged(ps);
+}
+
+void CUnit::PhysicalStateChanged(unsigned int prevState)
+{
+	const bool inAir      = ((prevState & PSTATE_BIT_INAIR     ) != 0);
+	const bool inWater    = ((prevState & PSTATE_BIT_INWATER   ) != 0);
+	const bool underWater = ((prevState & PSTATE_BIT_UNDERWATER) != 0);
 
 	if (IsInAir() != inAir) {
 		if (IsInAir()) {
@@ -85,6 +85,9 @@ public:
 	virtual void Update();
 	virtual void SlowUpdate();
 
+	/// unit-local part of the per-frame update, run in parallel by UnitHandler
+	void UpdateLocalMt();
+
 	const SolidObjectDef* GetDef() const { return ((const SolidObjectDef*) unitDef); }
 
 	virtual void DoDamage(const DamageArray& damages, const float3& impulse, CUnit* attacker, int weaponDefID, int projectileID);
@@ -150,6 +153,7 @@ public:
 	void CalculateTerrainType();
 	void UpdateTerrainType();
 	void UpdatePhysicalState(float eps);
+	void PhysicalStateChanged(unsigned int prevState);
 
 	float3 GetErrorVector(int allyteam) const;
 	float3 GetErrorPos(int allyteam, bool aiming = false) const { return (aiming? aimPos: midPos) + GetErrorVector(allyteam); }
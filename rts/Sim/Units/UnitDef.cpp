@@ -12,7 +12,6 @@
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/Weapons/WeaponDefHandler.h"
 #include "Sim/Units/CommandAI/Command.h"
-#include "Rendering/IconHandler.h"
 #include "System/EventHandler.h"
 #include "System/Exceptions.h"
 #include "System/Log/ILog.h"
@@ -260,10 +259,15 @@ UnitDef::UnitDef()
 }
 
 
-UnitDef::UnitDef(const LuaTable& udTable, const std::string& unitName, int id)
+UnitDef::UnitDef(const LuaTable& udTable, const std::string& unitName, int id): UnitDef()
 {
-	// rely on default-ctor to initialize all members
-	*this = UnitDef();
+	Parse(udTable, unitName, id);
+}
+
+
+void UnitDef::Parse(const LuaTable& udTable, const std::string& unitName, int id)
+{
+	// relies on the default-ctor having initialized all members
 	this->id = id;
 
 	name = unitName;
@@ -531,8 +535,6 @@ UnitDef::UnitDef(const LuaTable& udTable, const std::string& unitName, int id)
 	category = CCategoryHandler::Instance()->GetCategories(udTable.GetString("category", ""));
 	noChaseCategory = CCategoryHandler::Instance()->GetCategories(udTable.GetString("noChaseCategory", ""));
 
-	iconType = icon::iconHandler.GetIcon(udTable.GetString("iconType", "default"));
-
 	shieldWeaponDef    = nullptr;
 	stockpileWeaponDef = nullptr;
 
@@ -697,11 +699,10 @@ UnitDef::UnitDef(const LuaTable& udTable, const std::string& unitName, int id)
 }
 
 
-void UnitDef::ParseWeaponsTable(const LuaTable& weaponsTable)
+template<typename F>
+static void ForEachWeaponEntry(const LuaTable& weaponsTable, F&& func)
 {
-	const WeaponDef* noWeaponDef = weaponDefHandler->GetWeaponDef("NOWEAPON");
-
-	for (int k = 0, w = 0; w < MAX_WEAPONS_PER_UNIT; w++) {
+	for (int w = 0; w < MAX_WEAPONS_PER_UNIT; w++) {
 		LuaTable wTable;
 		std::string wdName = weaponsTable.GetString(w + 1, "");
 
@@ -726,9 +727,20 @@ void UnitDef::ParseWeaponsTable(const LuaTable& weaponsTable)
 			break;
 		}
 
+		func(w, wd, wdName, wTable);
+	}
+}
+
+void UnitDef::ParseWeaponsTable(const LuaTable& weaponsTable)
+{
+	const WeaponDef* noWeaponDef = weaponDefHandler->GetWeaponDef("NOWEAPON");
+
+	int k = 0;
+
+	ForEachWeaponEntry(weaponsTable, [&](int w, const WeaponDef* wd, const std::string& wdName, const LuaTable& wTable) {
 		while (k < w) {
 			if (noWeaponDef == nullptr) {
-				LOG_L(L_ERROR, "[%s] missing NOWEAPON for WeaponDef %s (#%d) of UnitDef %s", __func__, wdName.c_str(), w, humanName.c_str());
+				LOG_L(L_ERROR, "[ParseWeaponsTable] missing NOWEAPON for WeaponDef %s (#%d) of UnitDef %s", wdName.c_str(), w, humanName.c_str());
 				break;
 			}
 
@@ -753,7 +765,22 @@ void UnitDef::ParseWeaponsTable(const LuaTable& weaponsTable)
 			if (wd->interceptor || stockpileWeaponDef == nullptr || !stockpileWeaponDef->interceptor)
 				stockpileWeaponDef = wd;
 		}
-	}
+	});
+}
+
+
+void UnitDef::RegisterCategories(const LuaTable& udTable)
+{
+	CCategoryHandler* categoryHandler = CCategoryHandler::Instance();
+
+	// category bits are handed out by first use, see UnitDef and UnitDefWeapon
+	categoryHandler->GetCategories(udTable.GetString("category", ""));
+	categoryHandler->GetCategories(udTable.GetString("noChaseCategory", ""));
+
+	ForEachWeaponEntry(udTable.SubTable("weapons"), [&](int w, const WeaponDef* wd, const std::string& wdName, const LuaTable& wTable) {
+		categoryHandler->GetCategories(wTable.GetString("badTargetCategory", ""));
+		categoryHandler->GetCategories(wTable.GetString("onlyTargetCategory", ""));
+	});
 }
 
 
@@ -839,7 +866,7 @@ void UnitDef::CreateYardMap(std::string&& yardMapStr)
 void UnitDef::SetNoCost(bool noCost)
 {
 	if (noCost) {
-		// initialized from UnitDefHandler::PushNewUnitDef
+		// initialized from UnitDefHandler::FinalizeUnitDef
 		realMetalCost    = metal;
 		realEnergyCost   = energy;
 		realMetalUpkeep  = metalUpkeep;
@@ -55,6 +55,13 @@ public:
 	UnitDef(const LuaTable& udTable, const std::string& unitName, int id);
 	UnitDef();
 
+	/// fills a default-constructed def from <udTable>; iconType is left alone
+	/// since its refcount is not thread-safe (see CUnitDefHandler::FinalizeUnitDef)
+	void Parse(const LuaTable& udTable, const std::string& unitName, int id);
+
+	/// requests the categories a def built from <udTable> would, in the same order
+	static void RegisterCategories(const LuaTable& udTable);
+
 	void SetNoCost(bool noCost);
 
 	bool IsTransportUnit()     const { return (transportCapacity > 0 && transportMass > 0.0f); }
@@ -9,10 +9,13 @@
 #include "UnitDefHandler.h"
 #include "UnitDef.h"
 #include "Lua/LuaParser.h"
+#include "Rendering/IconHandler.h"
 #include "System/Exceptions.h"
 #include "System/Log/ILog.h"
 #include "System/StringUtil.h"
 #include "System/Sound/ISound.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/TimeProfiler.h"
 
 
 static CUnitDefHandler gUnitDefHandler;
@@ -36,18 +39,74 @@ void CUnitDefHandler::Init(LuaParser* defsParser)
 		throw content_error("Error loading UnitDefs");
 
 	std::vector<std::string> unitDefNames;
+	std::vector<std::string> unitDefErrors;
+	std::vector<LuaTable> unitDefTables;
+
 	rootTable.GetKeys(unitDefNames);
 
+	unitDefErrors.resize(unitDefNames.size());
+	unitDefTables.resize(unitDefNames.size());
+
 	unitDefIDs.reserve(unitDefNames.size() + 1);
 	unitDefsVector.reserve(unitDefNames.size() + 1);
 	unitDefsVector.emplace_back();
 
-	for (unsigned int a = 0; a < unitDefNames.size(); ++a) {
-		const string& unitName = unitDefNames[a];
-		const LuaTable& udTable = rootTable.SubTable(unitName);
+	{
+		SCOPED_ONCE_TIMER("UnitDefHandler::Init (Snapshot)");
+
+		// the parser's lua_State can only be read from one thread, copy the
+		// defs out of it; categories get their bits in order of first use so
+		// they are registered here, leaving only lookups to the parallel part
+		for (size_t i = 0; i < unitDefNames.size(); i++) {
+			unitDefTables[i] = rootTable.SubTable(unitDefNames[i]).Snapshot();
+
+			UnitDef::RegisterCategories(unitDefTables[i]);
+			StringToLowerInPlace(unitDefNames[i]);
+
+			if (std::find_if(unitDefNames[i].begin(), unitDefNames[i].end(), isblank) != unitDefNames[i].end())
+				LOG_L(L_WARNING, "[%s] UnitDef name \"%s\" contains white-spaces", __func__, unitDefNames[i].c_str());
+		}
+	}
+	{
+		SCOPED_ONCE_TIMER("UnitDefHandler::Init (Parse)");
+
+		// default-construct here, the workers only fill the defs in place; any
+		// UnitDef copy or temporary touches the (non-atomic) icon refcounts
+		unitDefsVector.resize(unitDefNames.size() + 1);
 
 		// parse the unitdef data (but don't load buildpics, etc...)
-		PushNewUnitDef(StringToLower(unitName), udTable);
+		for_mt(0, unitDefNames.size(), [&](const int i) {
+			try {
+				unitDefsVector[i + 1].Parse(unitDefTables[i], unitDefNames[i], i + 1);
+			} catch (const content_error& err) {
+				unitDefErrors[i] = err.what();
+			}
+		});
+	}
+	{
+		SCOPED_ONCE_TIMER("UnitDefHandler::Init (Finalize)");
+
+		// defs that failed are dropped and the ones after them moved down,
+		// which gives the same ids as adding each def in turn
+		int numDefs = 1;
+
+		for (size_t i = 0; i < unitDefNames.size(); i++) {
+			if (!unitDefErrors[i].empty()) {
+				LOG_L(L_ERROR, "%s", unitDefErrors[i].c_str());
+				continue;
+			}
+
+			const int defID = numDefs++;
+
+			if (defID != int(i + 1)) {
+				unitDefsVector[defID] = std::move(unitDefsVector[i + 1]);
+				unitDefsVector[defID].id = defID;
+			}
+
+			FinalizeUnitDef(unitDefsVector[defID], unitDefNames[i], unitDefTables[i]);
+		}
+
+		unitDefsVector.resize(numDefs);
 	}
 
 	CleanBuildOptions();
@@ -65,28 +124,36 @@ int CUnitDefHandler::PushNewUnitDef(const std::string& unitName, const LuaTable&
 
 	try {
 		unitDefsVector.emplace_back(udTable, unitName, defID);
-		UnitDef& newDef = unitDefsVector.back();
-		UnitDefLoadSounds(&newDef, udTable);
-
-		// map unitName to newDef.decoyName
-		if (!newDef.decoyName.empty())
-			decoyNameMap.emplace_back(unitName, StringToLower(newDef.decoyName));
-
-		// force-initialize the real* members
-		newDef.SetNoCost(true);
-		newDef.SetNoCost(noCost);
-
-		numPushResistantUnitDefs += int(newDef.pushResistant);
 	} catch (const content_error& err) {
 		LOG_L(L_ERROR, "%s", err.what());
 		return 0;
 	}
 
-	unitDefIDs[unitName] = defID;
+	FinalizeUnitDef(unitDefsVector.back(), unitName, udTable);
 	return defID;
 }
 
 
+void CUnitDefHandler::FinalizeUnitDef(UnitDef& newDef, const std::string& unitName, const LuaTable& udTable)
+{
+	newDef.iconType = icon::iconHandler.GetIcon(udTable.GetString("iconType", "default"));
+
+	UnitDefLoadSounds(&newDef, udTable);
+
+	// map unitName to newDef.decoyName
+	if (!newDef.decoyName.empty())
+		decoyNameMap.emplace_back(unitName, StringToLower(newDef.decoyName));
+
+	// force-initialize the real* members
+	newDef.SetNoCost(true);
+	newDef.SetNoCost(noCost);
+
+	numPushResistantUnitDefs += int(newDef.pushResistant);
+
+	unitDefIDs[unitName] = newDef.id;
+}
+
+
 void CUnitDefHandler::CleanBuildOptions()
 {
 	std::vector<int> eraseOpts;
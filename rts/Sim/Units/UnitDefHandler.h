@@ -61,6 +61,7 @@ public:
 	int NumPushResistantUnitDefs() const { return numPushResistantUnitDefs; }
 
 protected:
+	void FinalizeUnitDef(UnitDef& newDef, const std::string& unitName, const LuaTable& udTable);
 	void UnitDefLoadSounds(UnitDef*, const LuaTable&);
 	void LoadSounds(const LuaTable&, GuiSoundSet&, const std::string& soundName);
 
@@ -11,7 +11,9 @@
 #include "UnitTypes/Factory.h"
 
 #include "CommandAI/BuilderCAI.h"
+#include "Map/ReadMap.h"
 #include "Sim/Ecs/Registry.h"
+#include "Sim/Misc/AirUnitHash.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
@@ -42,7 +44,8 @@ CR_REG_METADATA(CUnitHandler, (
 
 	CR_MEMBER(builderCAIs),
 
-	CR_MEMBER(activeSlowUpdateUnit),
+	CR_MEMBER(slowUpdateBuckets),
+	CR_MEMBER(slowUpdateBucketCosts),
 	CR_MEMBER(activeUpdateUnit),
 
 	CR_MEMBER(maxUnits),
@@ -58,6 +61,22 @@ UnitMemPool unitMemPool;
 CUnitHandler unitHandler;
 
 
+// estimated relative cost of a unit's SlowUpdate; only depends
+// on the UnitDef so bucket assignment is the same on all clients
+static int GetSlowUpdateCost(const UnitDef* ud)
+{
+	int cost = 1;
+
+	// target searches (reclaim, repair, guard) and build-queue handling
+	cost += (ud->IsBuilderUnit() * 4);
+	cost += (ud->IsFactoryUnit() * 2);
+	// each weapon has its own SlowUpdate
+	cost += ud->NumWeapons();
+
+	return cost;
+}
+
+
 CUnit* CUnitHandler::NewUnit(const UnitDef* ud)
 {
 	// special static builder structures that can always be given
@@ -90,6 +109,8 @@ void CUnitHandler::Init() {
 	GeneralMoveSystem::Init();
 	UnitTrapCheckSystem::Init();
 
+	airUnitHash.Init(int2(mapDims.mapx, mapDims.mapy));
+
 	static_assert(sizeof(CBuilder) >= sizeof(CUnit             ), "");
 	static_assert(sizeof(CBuilder) >= sizeof(CBuilding         ), "");
 	static_assert(sizeof(CBuilder) >= sizeof(CExtractorBuilding), "");
@@ -107,7 +128,11 @@ void CUnitHandler::Init() {
 		maxUnitRadius = 0.0f;
 	}
 	{
-		activeSlowUpdateUnit = 0;
+		for (std::vector<CUnit*>& bucket: slowUpdateBuckets) {
+			bucket.clear();
+		}
+
+		slowUpdateBucketCosts.fill(0);
 		activeUpdateUnit = 0;
 	}
 	{
@@ -153,8 +178,14 @@ void CUnitHandler::Kill()
 		activeUnits.clear();
 		unitsToBeRemoved.clear();
 
+		for (std::vector<CUnit*>& bucket: slowUpdateBuckets) {
+			bucket.clear();
+		}
+
 		// only iterated by unsynced code, GetBuilderCAIs has no synced callers
 		builderCAIs.clear();
+
+		airUnitHash.Kill();
 	}
 	{
 		maxUnits = 0;
@@ -196,7 +227,6 @@ void CUnitHandler::InsertActiveUnit(CUnit* unit)
 	// do not (slow)update the same unit twice if the new one
 	// gets inserted behind our current iterator position and
 	// right-shifts the rest
-	activeSlowUpdateUnit += (insertionPos <= activeSlowUpdateUnit);
 	activeUpdateUnit += (insertionPos <= activeUpdateUnit);
 
 	#else
@@ -204,6 +234,32 @@ void CUnitHandler::InsertActiveUnit(CUnit* unit)
 	#endif
 
 	units[unit->id] = unit;
+
+	InsertSlowUpdateUnit(unit);
+}
+
+
+void CUnitHandler::InsertSlowUpdateUnit(CUnit* unit)
+{
+	// greedily balance the estimated per-frame cost; ties go to the lowest bucket
+	const auto iter = std::min_element(slowUpdateBucketCosts.begin(), slowUpdateBucketCosts.end());
+	const size_t bucketIdx = iter - slowUpdateBucketCosts.begin();
+
+	slowUpdateBuckets[bucketIdx].push_back(unit);
+	slowUpdateBucketCosts[bucketIdx] += GetSlowUpdateCost(unit->unitDef);
+}
+
+void CUnitHandler::RemoveSlowUpdateUnit(CUnit* unit)
+{
+	for (size_t bucketIdx = 0; bucketIdx < slowUpdateBuckets.size(); bucketIdx++) {
+		if (!spring::VectorErase(slowUpdateBuckets[bucketIdx], unit))
+			continue;
+
+		slowUpdateBucketCosts[bucketIdx] -= GetSlowUpdateCost(unit->unitDef);
+		return;
+	}
+
+	assert(false);
 }
 
 
@@ -292,10 +348,8 @@ void CUnitHandler::DeleteUnit(CUnit* delUnit)
 
 	teamHandler.Team(delUnitTeam)->RemoveUnit(delUnit, CTeam::RemoveDied);
 
-	if (activeSlowUpdateUnit > std::distance(activeUnits.begin(), it))
-		--activeSlowUpdateUnit;
-
 	activeUnits.erase(it);
+	RemoveSlowUpdateUnit(delUnit);
 
 	spring::VectorErase(GetUnitsByTeamAndDef(delUnitTeam,           0), delUnit);
 	spring::VectorErase(GetUnitsByTeamAndDef(delUnitTeam, delUnitType), delUnit);
@@ -318,6 +372,11 @@ void CUnitHandler::UpdateUnitMoveTypes()
 {
 	SCOPED_TIMER("Sim::Unit::MoveType");
 
+	{
+		SCOPED_TIMER("Sim::Unit::MoveType::0::AirUnitHash");
+		airUnitHash.Update(activeUnits);
+	}
+
 	GroundMoveSystem::Update();
 	GeneralMoveSystem::Update();
 	UnitTrapCheckSystem::Update();
@@ -338,23 +397,12 @@ void CUnitHandler::SlowUpdateUnits()
 {
 	SCOPED_TIMER("Sim::Unit::SlowUpdate");
 
-	assert(activeSlowUpdateUnit >= 0);
-
-	// reset the iterator every <UNIT_SLOWUPDATE_RATE> frames
-	if ((gs->frameNum % UNIT_SLOWUPDATE_RATE) == 0)
-		activeSlowUpdateUnit = 0;
-
-	const size_t idxBeg = activeSlowUpdateUnit;
-	const size_t maximumCnt = activeUnits.size() - idxBeg;
-	const size_t logicalCnt = (activeUnits.size() / UNIT_SLOWUPDATE_RATE) + 1;
-	const size_t indCnt = logicalCnt > maximumCnt ? maximumCnt : logicalCnt;
-	const size_t idxEnd = idxBeg + indCnt;
-
-	activeSlowUpdateUnit = idxEnd;
-
 	// stagger the SlowUpdate's
-	for (size_t i = idxBeg; i<idxEnd; ++i) {
-		CUnit* unit = activeUnits[i];
+	const std::vector<CUnit*>& bucket = slowUpdateBuckets[gs->frameNum % UNIT_SLOWUPDATE_RATE];
+
+	// units created in here (e.g. by Lua) wait for their own bucket to come up
+	for (size_t i = 0, n = bucket.size(); i < n; ++i) {
+		CUnit* unit = bucket[i];
 
 		unit->SanityCheck();
 		unit->SlowUpdate();
@@ -368,18 +416,43 @@ void CUnitHandler::UpdateUnits()
 {
 	SCOPED_TIMER("Sim::Unit::Update");
 
-	size_t activeUnitCount = activeUnits.size();
-	for (size_t i = 0; i < activeUnitCount; ++i) {
-		CUnit* unit = activeUnits[i];
+	// units created during this update (by factories) are not updated until next frame
+	const size_t activeUnitCount = activeUnits.size();
 
-		unit->SanityCheck();
-		unit->Update();
-		unit->moveType->UpdateCollisionMap();
-		// unsynced; done on-demand when drawing unit
-		// unit->UpdateLocalModel();
-		unit->SanityCheck();
+	{
+		SCOPED_TIMER("Sim::Unit::Update::1::UpdateST");
 
-		assert(activeUnits[i] == unit);
+		for (size_t i = 0; i < activeUnitCount; ++i) {
+			CUnit* unit = activeUnits[i];
+
+			unit->SanityCheck();
+			unit->Update();
+			unit->moveType->UpdateCollisionMap();
+			// unsynced; done on-demand when drawing unit
+			// unit->UpdateLocalModel();
+			unit->SanityCheck();
+
+			assert(activeUnits[i] == unit);
+		}
+	}
+	{
+		SCOPED_TIMER("Sim::Unit::Update::2::UpdateLocalMT");
+
+		prevPhysicalStates.resize(activeUnitCount);
+
+		for_mt(0, activeUnitCount, [this](const int i) {
+			CUnit* unit = activeUnits[i];
+
+			prevPhysicalStates[i] = unit->physicalState;
+			unit->UpdateLocalMt();
+		});
+	}
+	{
+		SCOPED_TIMER("Sim::Unit::Update::3::PhysicalStateEventsST");
+
+		for (size_t i = 0; i < activeUnitCount; ++i) {
+			activeUnits[i]->PhysicalStateChanged(prevPhysicalStates[i]);
+		}
 	}
 }
 
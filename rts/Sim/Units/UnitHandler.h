@@ -76,6 +76,8 @@ public:
 
 private:
 	void InsertActiveUnit(CUnit* unit);
+	void InsertSlowUpdateUnit(CUnit* unit);
+	void RemoveSlowUpdateUnit(CUnit* unit);
 	bool QueueDeleteUnit(CUnit* unit);
 	void QueueDeleteUnits();
 	void DeleteUnit(CUnit* unit);
@@ -102,8 +104,15 @@ private:
 
 	spring::unordered_map<unsigned int, CBuilderCAI*> builderCAIs;
 
+	///< physical state of each active unit before UpdateUnits' MT stage (not serialized)
+	std::vector<unsigned int> prevPhysicalStates;
+
+
+	///< units are SlowUpdate'd in the bucket for (frameNum % UNIT_SLOWUPDATE_RATE)
+	///< and put into whichever bucket has the lowest estimated total cost on creation
+	std::array<std::vector<CUnit*>, UNIT_SLOWUPDATE_RATE> slowUpdateBuckets;
+	std::array<int, UNIT_SLOWUPDATE_RATE> slowUpdateBucketCosts;
 
-	size_t activeSlowUpdateUnit = 0;  ///< first unit of batch that will be SlowUpdate'd this frame
 	size_t activeUpdateUnit = 0;      ///< first unit of batch that will be SlowUpdate'd this frame
 
 
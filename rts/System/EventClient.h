@@ -48,6 +48,31 @@ enum DbgTimingInfoType {
 };
 
 
+/**
+ * @brief one UnitDamaged event, as collected for UnitDamagedBatch
+ *
+ * Plain ids instead of unit pointers, units may be gone by the time
+ * the batch is delivered.
+ */
+struct UnitDamagedEvent {
+	int unitID;
+	int unitDefID;
+	int unitTeam;
+	int unitAllyTeam;
+
+	float damage;
+	bool paralyzer;
+
+	int weaponDefID;
+	int projectileID;
+
+	/// -1 if there was no attacker
+	int attackerID;
+	int attackerDefID;
+	int attackerTeam;
+};
+
+
 class CEventClient
 {
 	public:
@@ -140,6 +165,8 @@ class CEventClient
 			int weaponDefID,
 			int projectileID,
 			bool paralyzer) {}
+		/// all UnitDamaged events of a sim frame, delivered once at its end
+		virtual void UnitDamagedBatch(const std::vector<UnitDamagedEvent>& events) {}
 		virtual void UnitStunned(const CUnit* unit, bool stunned) {}
 		virtual void UnitExperience(const CUnit* unit, float oldExperience) {}
 		virtual void UnitHarvestStorageFull(const CUnit* unit) {}
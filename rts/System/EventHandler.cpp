@@ -5,6 +5,7 @@
 #include "Lua/LuaCallInCheck.h"
 #include "Lua/LuaOpenGL.h"  // FIXME -- should be moved
 
+#include "Sim/Units/UnitDef.h"
 #include "System/Config/ConfigHandler.h"
 #include "System/Platform/Threading.h"
 #include "System/GlobalConfig.h"
@@ -40,6 +41,11 @@ void CEventHandler::ResetState()
 	handles.clear();
 	handles.reserve(16);
 
+	unitDamagedEvents.clear();
+	unitDamagedEvents.reserve(1024);
+	unitDamagedEventsScratch.clear();
+	unitDamagedEventsScratch.reserve(1024);
+
 	SetupEvents();
 }
 
@@ -616,6 +622,64 @@ void CEventHandler::UnitHarvestStorageFull(const CUnit* unit)
 	}
 }
 
+
+void CEventHandler::AddUnitDamagedEvent(
+	const CUnit* unit,
+	const CUnit* attacker,
+	float damage,
+	int weaponDefID,
+	int projectileID,
+	bool paralyzer)
+{
+	UnitDamagedEvent& e = unitDamagedEvents.emplace_back();
+
+	e.unitID = unit->id;
+	e.unitDefID = unit->unitDef->id;
+	e.unitTeam = unit->team;
+	e.unitAllyTeam = unit->allyteam;
+
+	e.damage = damage;
+	e.paralyzer = paralyzer;
+
+	e.weaponDefID = weaponDefID;
+	e.projectileID = projectileID;
+
+	e.attackerID    = (attacker != nullptr)? attacker->id          : -1;
+	e.attackerDefID = (attacker != nullptr)? attacker->unitDef->id : -1;
+	e.attackerTeam  = (attacker != nullptr)? attacker->team        : -1;
+}
+
+void CEventHandler::DeliverBatchedEvents()
+{
+	ZoneScoped;
+
+	if (unitDamagedEvents.empty())
+		return;
+
+	for (size_t i = 0; i < listUnitDamagedBatch.size(); ) {
+		CEventClient* ec = listUnitDamagedBatch[i];
+
+		if (ec->GetFullRead()) {
+			ec->UnitDamagedBatch(unitDamagedEvents);
+		} else {
+			unitDamagedEventsScratch.clear();
+
+			for (const UnitDamagedEvent& e: unitDamagedEvents) {
+				if (ec->CanReadAllyTeam(e.unitAllyTeam))
+					unitDamagedEventsScratch.push_back(e);
+			}
+
+			if (!unitDamagedEventsScratch.empty())
+				ec->UnitDamagedBatch(unitDamagedEventsScratch);
+		}
+
+		// the call-in may remove itself from the list
+		i += (i < listUnitDamagedBatch.size() && ec == listUnitDamagedBatch[i]);
+	}
+
+	unitDamagedEvents.clear();
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -94,6 +94,16 @@ class CEventHandler
 		void UnitExperience(const CUnit* unit, float oldExperience);
 		void UnitHarvestStorageFull(const CUnit* unit);
 
+		/**
+		 * @brief hands the events collected for the *Batch call-ins to
+		 *        their clients, called once at the end of every sim frame
+		 *
+		 * Events are only collected while some client is registered for
+		 * the batched variant; clients that want batches only register
+		 * the *Batch call-in and thereby skip per-event dispatch.
+		 */
+		void DeliverBatchedEvents();
+
 		void UnitSeismicPing(const CUnit* unit, int allyTeam,
 		                     const float3& pos, float strength);
 		void UnitEnteredRadar(const CUnit* unit, int allyTeam);
@@ -344,9 +354,22 @@ class CEventHandler
 		void ListInsert(EventClientList& ciList, CEventClient* ec);
 		void ListRemove(EventClientList& ciList, CEventClient* ec);
 
+		void AddUnitDamagedEvent(
+			const CUnit* unit,
+			const CUnit* attacker,
+			float damage,
+			int weaponDefID,
+			int projectileID,
+			bool paralyzer);
+
 	private:
 		CEventClient* mouseOwner;
 
+		/// UnitDamaged events of the current frame, for UnitDamagedBatch
+		std::vector<UnitDamagedEvent> unitDamagedEvents;
+		/// per-client subset of the above, for clients without full read access
+		std::vector<UnitDamagedEvent> unitDamagedEventsScratch;
+
 	private:
 		EventMap eventMap;
 
@@ -537,6 +560,11 @@ inline void CEventHandler::UnitDamaged(
 	bool paralyzer)
 {
 	ITERATE_UNIT_ALLYTEAM_EVENTCLIENTLIST(UnitDamaged, unit, attacker, damage, weaponDefID, projectileID, paralyzer)
+
+	if (listUnitDamagedBatch.empty())
+		return;
+
+	AddUnitDamagedEvent(unit, attacker, damage, weaponDefID, projectileID, paralyzer);
 }
 
 inline void CEventHandler::UnitStunned(
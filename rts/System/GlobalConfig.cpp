@@ -50,6 +50,16 @@ CONFIG(int, LinkIncomingMaxWaitingPackets)
 	.defaultValue(512)
 	.minimumValue(0);
 
+CONFIG(int, NetworkCompressionLevel)
+	.defaultValue(0)
+	.minimumValue(0)
+	.maximumValue(9)
+	.description("zlib level used to compress outgoing network data, 0 disables. Servers enable it per client, clients only compress once the server does.");
+
+CONFIG(bool, NetworkRecvThread)
+	.defaultValue(false)
+	.description("Read, parse and checksum incoming packets of the game server on a separate thread.");
+
 CONFIG(int, TeamHighlight)
 	.defaultValue(CTeamHighlight::HIGHLIGHT_PLAYERS)
 	.minimumValue(CTeamHighlight::HIGHLIGHT_FIRST)
@@ -80,6 +90,8 @@ void GlobalConfig::Init()
 	linkIncomingPeakBandwidth = configHandler->GetInt("LinkIncomingPeakBandwidth");
 	linkIncomingMaxPacketRate = configHandler->GetInt("LinkIncomingMaxPacketRate");
 	linkIncomingMaxWaitingPackets = configHandler->GetInt("LinkIncomingMaxWaitingPackets");
+	networkCompressionLevel = configHandler->GetInt("NetworkCompressionLevel");
+	networkRecvThread = configHandler->GetBool("NetworkRecvThread");
 
 	if (linkIncomingSustainedBandwidth > 0 && linkIncomingPeakBandwidth < linkIncomingSustainedBandwidth)
 		linkIncomingPeakBandwidth = linkIncomingSustainedBandwidth;
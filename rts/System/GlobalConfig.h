@@ -82,6 +82,23 @@ public:
 	 */
 	int linkIncomingMaxWaitingPackets = 512;
 
+	/**
+	 * @brief networkCompressionLevel
+	 *
+	 * zlib level (1-9) for compressing outgoing UDP payloads, 0 disables;
+	 * servers enable it per client, clients follow once they receive
+	 * compressed data
+	 */
+	int networkCompressionLevel = 0;
+
+	/**
+	 * @brief networkRecvThread
+	 *
+	 * Whether the server's UDPListener receives, parses and checksums
+	 * datagrams on its own thread instead of the server thread
+	 */
+	bool networkRecvThread = false;
+
 
 	/**
 	 * @brief useNetMessageSmoothingBuffer
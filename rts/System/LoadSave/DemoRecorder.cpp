@@ -3,7 +3,10 @@
 #include <cassert>
 #include <cerrno>
 #include <cstring>
+#include <deque>
+#include <fstream>
 #include <memory>
+#include <zlib.h>
 
 #include "DemoRecorder.h"
 #include "Game/GameVersion.h"
@@ -15,7 +18,8 @@
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/Log/ILog.h"
-#include "System/Threading/ThreadPool.h"
+#include "System/Platform/Threading.h"
+#include "System/Threading/SpringThreading.h"
 
 #ifdef CreateDirectory
 #undef CreateDirectory
@@ -26,40 +30,227 @@
 #endif
 
 
-// server and client memory-streams
-static std::string demoStreams[2];
-static spring::mutex demoMutex;
+static constexpr size_t DEMO_CHUNK_SIZE = 1024 * 1024;
+// maximum amount of uncompressed data queued for the writer
+static constexpr size_t DEMO_MAX_PENDING_SIZE = 16 * DEMO_CHUNK_SIZE;
+// game-time after which a chunk is flushed regardless of its size
+static constexpr float DEMO_CHUNK_TIME = 60.0f;
 
 
-CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
+// compresses <size> bytes into a complete (self-contained) gzip member;
+// with level 0 the output size only depends on the input size
+static std::string CompressGZipMember(const char* data, size_t size, int level)
+{
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+
+	// +16 selects a gzip wrapper (with zeroed mtime, so the header is fixed)
+	if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return {};
+
+	std::string member(deflateBound(&zs, size), 0);
+
+	zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+	zs.avail_in = size;
+	zs.next_out = reinterpret_cast<Bytef*>(member.data());
+	zs.avail_out = member.size();
+
+	if (deflate(&zs, Z_FINISH) != Z_STREAM_END)
+		member.clear();
+	else
+		member.resize(zs.total_out);
+
+	deflateEnd(&zs);
+	return member;
+}
+
+
+
+/**
+ * Compresses and appends demo stream chunks on a dedicated thread. A file
+ * of concatenated gzip members is itself a valid gzip file, so CDemoReader
+ * (gzread) sees one continuous stream. The header is stored uncompressed in
+ * the first member which has a constant size, allowing it to be rewritten
+ * in-place whenever the recorder updates it.
+ */
+class CDemoStreamWriter
 {
-	std::lock_guard<spring::mutex> lock(demoMutex);
+public:
+	CDemoStreamWriter(const std::string& fileName)
+		: file(fileName, std::ios::out | std::ios::binary | std::ios::trunc)
+	{
+		if (!(valid = file.is_open()))
+			return;
+
+		thread = spring::thread(&CDemoStreamWriter::Run, this);
+	}
+
+	~CDemoStreamWriter() {
+		{
+			std::lock_guard<spring::mutex> lock(mutex);
+			quit = true;
+		}
+
+		cond.notify_all();
+
+		if (thread.joinable())
+			thread.join();
+	}
+
+	bool IsValid() const { return valid; }
+
+	void WriteHeader(const DemoFileHeader& header) { AddJob(std::string(reinterpret_cast<const char*>(&header), sizeof(header)), true); }
+	void WriteChunk(std::string&& data) { AddJob(std::move(data), false); }
+
+private:
+	struct Job {
+		std::string data;
+		bool header;
+	};
+
+	void AddJob(std::string&& data, bool header) {
+		{
+			std::unique_lock<spring::mutex> lock(mutex);
+
+			// only blocks if compression can not keep up with the game
+			cond.wait(lock, [&]() { return (pendingSize < DEMO_MAX_PENDING_SIZE); });
+
+			pendingSize += data.size();
+			jobs.push_back({std::move(data), header});
+		}
+
+		cond.notify_all();
+	}
+
+	void Run() {
+		Threading::SetThreadName("demo-writer");
+
+		while (true) {
+			Job job;
+
+			{
+				std::unique_lock<spring::mutex> lock(mutex);
+				cond.wait(lock, [&]() { return (quit || !jobs.empty()); });
+
+				// quit only after everything was written
+				if (jobs.empty())
+					return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			const size_t jobSize = job.data.size();
+
+			if (job.header) {
+				WriteHeaderMember(job.data);
+			} else {
+				WriteDataMember(job.data);
+			}
+
+			{
+				std::lock_guard<spring::mutex> lock(mutex);
+				pendingSize -= jobSize;
+			}
+
+			cond.notify_all();
+		}
+	}
+
+	void WriteHeaderMember(const std::string& data) {
+		const std::string member = CompressGZipMember(data.data(), data.size(), 0);
+
+		if (headerMemberSize == 0) {
+			// first job, file is still empty
+			headerMemberSize = member.size();
+			file.write(member.data(), member.size());
+		} else {
+			assert(member.size() == headerMemberSize);
 
+			file.seekp(0);
+			file.write(member.data(), member.size());
+			file.seekp(0, std::ios::end);
+		}
+
+		file.flush();
+	}
+
+	void WriteDataMember(const std::string& data) {
+		const std::string member = CompressGZipMember(data.data(), data.size(), 9);
+
+		if (member.empty()) {
+			LOG_L(L_ERROR, "[DemoStreamWriter::%s] could not compress " _STPF_ " bytes", __func__, data.size());
+			return;
+		}
+
+		file.write(member.data(), member.size());
+		file.flush();
+	}
+
+private:
+	std::ofstream file;
+
+	spring::thread thread;
+	spring::mutex mutex;
+	spring::condition_variable_any cond;
+
+	std::deque<Job> jobs;
+
+	size_t pendingSize = 0;
+	size_t headerMemberSize = 0;
+
+	bool valid = false;
+	bool quit = false;
+};
+
+
+
+CDemoRecorder::CDemoRecorder() { memset(&fileHeader, 0, sizeof(fileHeader)); }
+CDemoRecorder::CDemoRecorder(CDemoRecorder&& r) { *this = std::move(r); }
+
+CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
+{
 	SetStream();
 	SetName(mapName, modName);
 	SetFileHeader();
-	WriteFileHeader(false);
 
-	file = gzopen(demoName.c_str(), "wb9");
+	if (demoName.empty())
+		return;
+
+	writer = std::make_unique<CDemoStreamWriter>(demoName);
+
+	if (!writer->IsValid()) {
+		LOG_L(L_ERROR, "[DemoRecorder::%s] could not open %s-demo \"%s\"", __func__, (isServerDemo? "server": "client"), demoName.c_str());
+		writer.reset();
+		return;
+	}
+
+	WriteFileHeader(false);
 }
 
 CDemoRecorder::~CDemoRecorder()
 {
-	if (file == nullptr)
+	if (writer == nullptr)
 		return;
 
 	WriteWinnerList();
 	WritePlayerStats();
 	WriteTeamStats();
+	FlushChunk();
 	WriteFileHeader(true);
-	WriteDemoFile();
+
+	LOG("[DemoRecorder::%s] finishing %s-demo \"%s\" (%d stream bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), fileHeader.demoStreamSize);
+
+	// waits for all pending chunks to be written
+	writer.reset();
 }
 
 
 void CDemoRecorder::SetStream()
 {
-	demoStreams[isServerDemo].clear();
-	demoStreams[isServerDemo].reserve(8 * 1024 * 1024);
+	chunk.clear();
+	chunk.reserve(DEMO_CHUNK_SIZE + 64 * 1024);
+	chunkStartTime = 0.0f;
 }
 
 void CDemoRecorder::SetFileHeader()
@@ -76,31 +267,16 @@ void CDemoRecorder::SetFileHeader()
 	fileHeader.winningAllyTeamsSize = 0;
 }
 
-void CDemoRecorder::WriteDemoFile()
+void CDemoRecorder::FlushChunk()
 {
-	// zlib FAQ claims the lib is thread-safe, "however any library routines that zlib uses and
-	// any application-provided memory allocation routines must also be thread-safe. zlib's gz*
-	// functions use stdio library routines, and most of zlib's functions use the library memory
-	// allocation routines by default" (so code below should be OK)
-	// gz* should usually be finished before ctor runs again when reloading, but take no chances
-	std::string& data = demoStreams[isServerDemo];
-	std::function<void(gzFile, std::string&)> func = [](gzFile file, std::string& data) {
-		std::lock_guard<spring::mutex> lock(demoMutex);
-
-		gzwrite(file, data.c_str(), data.size());
-		gzflush(file, Z_FINISH);
-		gzclose(file);
-	};
+	if (writer == nullptr || chunk.empty())
+		return;
 
-	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), data.size());
+	std::string data;
+	data.reserve(chunk.capacity());
 
-	#ifndef _WIN32
-	// NOTE: can not use ThreadPool for this directly here, workers are already gone
-	// FIXME: does not currently (august 2017) compile on Windows mingw buildbots
-	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data)));
-	#else
-	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data))));
-	#endif
+	std::swap(data, chunk);
+	writer->WriteChunk(std::move(data));
 }
 
 void CDemoRecorder::WriteSetupText(const std::string& text)
@@ -116,7 +292,10 @@ void CDemoRecorder::WriteSetupText(const std::string& text)
 	}
 
 	fileHeader.scriptSize = length;
-	demoStreams[isServerDemo].append(text.c_str(), length);
+	chunk.append(text.c_str(), length);
+
+	// make the script size part of the on-disk header right away
+	WriteFileHeader(false);
 }
 
 void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime)
@@ -126,9 +305,16 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	chunkHeader.modGameTime = modGameTime;
 	chunkHeader.length = length;
 	chunkHeader.swab();
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
+
+	if (chunk.empty())
+		chunkStartTime = modGameTime;
+
+	chunk.append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
+	chunk.append(reinterpret_cast<const char*>(buf), length);
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
+
+	if (chunk.size() >= DEMO_CHUNK_SIZE || (modGameTime - chunkStartTime) >= DEMO_CHUNK_TIME)
+		FlushChunk();
 }
 
 void CDemoRecorder::SetName(const std::string& mapName, const std::string& modName)
@@ -225,10 +411,14 @@ void CDemoRecorder::SetWinningAllyTeams(const std::vector<unsigned char>& winnin
 }
 
 /** @brief Write DemoFileHeader
-Write the DemoFileHeader at the start of the file and restores the original
-position in the file afterwards. */
-unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
+Hands the DemoFileHeader to the writer which (re)writes it at the start of
+the file. The stream length is only stored once the demo is complete, so
+readers of an unfinished demo play it until EOF. */
+void CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 {
+	if (writer == nullptr)
+		return;
+
 	DemoFileHeader tmpHeader;
 	memcpy(&tmpHeader, &fileHeader, sizeof(fileHeader));
 
@@ -238,28 +428,21 @@ unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 	// to little endian
 	tmpHeader.swab();
 
-	if (demoStreams[isServerDemo].empty()) {
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
-	} else {
-		assert(demoStreams[isServerDemo].size() >= sizeof(tmpHeader));
-		memcpy(&demoStreams[isServerDemo][0], reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader)); // no non-const .data() until C++17
-	}
-
-	return (demoStreams[isServerDemo].size());
+	writer->WriteHeader(tmpHeader);
 }
 
 /** @brief Write the CPlayer::Statistics at the current position in the file. */
 void CDemoRecorder::WritePlayerStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = chunk.size();
 
 	for (PlayerStatistics& stats: playerStats) {
 		stats.swab();
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
+		chunk.append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
 	}
 
 	fileHeader.numPlayers = playerStats.size();
-	fileHeader.playerStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.playerStatSize = int(chunk.size() - pos);
 
 	playerStats.clear();
 }
@@ -272,38 +455,38 @@ void CDemoRecorder::WriteWinnerList()
 	if (fileHeader.numTeams == 0)
 		return;
 
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = chunk.size();
 
 	// Write the array of winningAllyTeams.
 	for (size_t i = 0; i < winningAllyTeams.size(); i++) { // NOLINT{modernize-loop-convert}
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
+		chunk.append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
 	}
 
 	winningAllyTeams.clear();
 
-	fileHeader.winningAllyTeamsSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.winningAllyTeamsSize = int(chunk.size() - pos);
 }
 
 /** @brief Write the TeamStatistics at the current position in the file. */
 void CDemoRecorder::WriteTeamStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = chunk.size();
 
 	// Write array of dwords indicating number of TeamStatistics per team.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		unsigned int c = swabDWord(history.size());
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
+		chunk.append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
 	}
 
 	// Write big array of TeamStatistics.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		for (TeamStatistics& stats: history) {
 			stats.swab();
-			demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
+			chunk.append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
 		}
 	}
 
-	fileHeader.teamStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.teamStatSize = int(chunk.size() - pos);
 
 	teamStats.clear();
 }
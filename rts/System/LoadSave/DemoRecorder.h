@@ -3,26 +3,32 @@
 #ifndef DEMO_RECORDER
 #define DEMO_RECORDER
 
+#include <memory>
 #include <vector>
 #include <sstream>
-#include <zlib.h>
 
 #include "Demo.h"
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
 
 
+class CDemoStreamWriter;
+
 /**
  * @brief Used to record demos
+ *
+ * The stream is collected in chunks which are compressed into separate gzip
+ * members and appended to the file by a background writer, so memory use is
+ * bounded and a crashed game still leaves a playable (headerless-length) demo.
  */
 class CDemoRecorder : public CDemo
 {
 public:
-	CDemoRecorder() { memset(&fileHeader, 0, sizeof(fileHeader)); }
+	CDemoRecorder();
 	CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo);
 
 	CDemoRecorder(const CDemoRecorder&) = delete;
-	CDemoRecorder(CDemoRecorder&& r) { *this = std::move(r); }
+	CDemoRecorder(CDemoRecorder&& r);
 
 	~CDemoRecorder();
 
@@ -32,7 +38,9 @@ public:
 		memcpy(&fileHeader, &r.fileHeader, sizeof(fileHeader));
 		memset(&r.fileHeader, 0, sizeof(fileHeader));
 
-		std::swap(file, r.file);
+		std::swap(writer, r.writer);
+		std::swap(chunk, r.chunk);
+		std::swap(chunkStartTime, r.chunkStartTime);
 
 		std::swap(demoName, r.demoName);
 		std::swap(playerStats, r.playerStats);
@@ -44,7 +52,7 @@ public:
 	}
 
 
-	bool IsValid() const { return (file != nullptr); }
+	bool IsValid() const { return (writer != nullptr); }
 
 	void WriteSetupText(const std::string& text);
 	void SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime);
@@ -63,15 +71,19 @@ public:
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
 private:
-	unsigned int WriteFileHeader(bool updateStreamLength);
+	void WriteFileHeader(bool updateStreamLength);
 	void SetFileHeader();
 	void WritePlayerStats();
 	void WriteTeamStats();
 	void WriteWinnerList();
-	void WriteDemoFile();
+	void FlushChunk();
 
 private:
-	gzFile file = nullptr;
+	std::unique_ptr<CDemoStreamWriter> writer;
+
+	/// uncompressed stream data not yet handed to <writer>
+	std::string chunk;
+	float chunkStartTime = 0.0f;
 
 	std::vector<PlayerStatistics> playerStats;
 	std::vector< std::vector<TeamStatistics> > teamStats;
@@ -49,6 +49,10 @@
  *
  * If Spring did not cleanup properly (crashed), the demoStreamSize is 0 and it
  * can be assumed the demo stream continues until the end of the file.
+ *
+ * The file is gzip-compressed as a sequence of concatenated gzip members, the
+ * first of which holds only the (uncompressed) header; gzread treats these as
+ * a single stream.
  */
 struct DemoFileHeader
 {
@@ -4,8 +4,11 @@
 #define MEMPOOL_TYPES_H
 
 #include <cassert>
+#include <cstddef>
+#include <cstdlib>
 #include <cstring> // memset
 #include <cmath>
+#include <algorithm>
 #include <array>
 #include <deque>
 #include <vector>
@@ -61,6 +64,140 @@ private:
 	sm_allocator space = nullptr;
 };
 
+
+// size-class allocator for callers that pass the block size back on free and
+// realloc (e.g. Lua's lua_Alloc), so blocks carry no header; every class cuts
+// its blocks from dedicated slabs and recycles them through an intrusive free
+// list while larger requests go to malloc. Not thread-safe, meant to be owned
+// by a single Lua state (and therefore a single thread at any time).
+template<size_t NumClasses, size_t ClassStep, size_t SlabSize> struct SlabPool {
+public:
+	static_assert((ClassStep % alignof(std::max_align_t)) == 0, "");
+	static_assert(SlabSize >= (NumClasses * ClassStep), "");
+
+	static constexpr size_t MAX_ALLOC_SIZE = NumClasses * ClassStep;
+
+	SlabPool() = default;
+	SlabPool(const SlabPool& p) = delete;
+	SlabPool& operator = (const SlabPool& p) = delete;
+	~SlabPool() { clear(); }
+
+	void* allocMem(size_t size) {
+		if (size > MAX_ALLOC_SIZE)
+			return (std::malloc(size));
+
+		SizeClass& sc = classes[GetClassIndex(size)];
+		uint8_t* ptr = sc.freeList;
+
+		if (ptr != nullptr) {
+			std::memcpy(&sc.freeList, ptr, sizeof(uint8_t*));
+		} else {
+			if (sc.slabPtr == sc.slabEnd && !AddSlab(sc, GetClassSize(size)))
+				return nullptr;
+
+			ptr = sc.slabPtr;
+			sc.slabPtr += GetClassSize(size);
+		}
+
+		sc.numUsed += 1;
+		return ptr;
+	}
+
+	void freeMem(void* ptr, size_t size) {
+		if (ptr == nullptr)
+			return;
+
+		if (size > MAX_ALLOC_SIZE) {
+			std::free(ptr);
+			return;
+		}
+
+		SizeClass& sc = classes[GetClassIndex(size)];
+
+		assert(sc.numUsed > 0);
+		std::memcpy(ptr, &sc.freeList, sizeof(uint8_t*));
+
+		sc.freeList = static_cast<uint8_t*>(ptr);
+		sc.numUsed -= 1;
+	}
+
+	void* reAllocMem(void* ptr, size_t osize, size_t nsize) {
+		if (ptr == nullptr)
+			return (allocMem(nsize));
+
+		if (osize > MAX_ALLOC_SIZE && nsize > MAX_ALLOC_SIZE)
+			return (std::realloc(ptr, nsize));
+
+		// block is already large enough and not wastefully so
+		if (osize <= MAX_ALLOC_SIZE && nsize <= MAX_ALLOC_SIZE && GetClassIndex(osize) == GetClassIndex(nsize))
+			return ptr;
+
+		void* nptr = allocMem(nsize);
+
+		if (nptr == nullptr)
+			return nullptr;
+
+		std::memcpy(nptr, ptr, std::min(osize, nsize));
+		freeMem(ptr, osize);
+		return nptr;
+	}
+
+	bool isAllocInternal(size_t size) const { return (size <= MAX_ALLOC_SIZE); }
+
+	// releases all slabs at once; blocks handed out before become invalid
+	// note: malloc'ed (external) blocks must have been freed by the caller
+	void clear() {
+		for (uint8_t* slab: slabs) {
+			std::free(slab);
+		}
+
+		slabs.clear();
+		classes = {};
+	}
+
+	size_t slab_size() const { return (slabs.size() * SlabSize); } // bytes reserved by all slabs
+	size_t used_size() const { // bytes of slab memory handed out in blocks
+		size_t sum = 0;
+
+		for (size_t i = 0; i < NumClasses; i++) {
+			sum += (classes[i].numUsed * (i + 1) * ClassStep);
+		}
+
+		return sum;
+	}
+	// fraction of slab memory not in use, either free-listed or not yet cut
+	float fragmentation() const { return (1.0f - used_size() / std::max(float(slab_size()), 1.0f)); }
+
+private:
+	struct SizeClass {
+		uint8_t* freeList = nullptr;
+		uint8_t* slabPtr = nullptr;
+		uint8_t* slabEnd = nullptr;
+
+		size_t numUsed = 0;
+	};
+
+	static constexpr size_t GetClassIndex(size_t size) { return ((std::max(size, size_t(1)) - 1) / ClassStep); }
+	static constexpr size_t GetClassSize(size_t size) { return ((GetClassIndex(size) + 1) * ClassStep); }
+
+	bool AddSlab(SizeClass& sc, size_t classSize) {
+		uint8_t* slab = static_cast<uint8_t*>(std::malloc(SlabSize));
+
+		if (slab == nullptr)
+			return false;
+
+		slabs.push_back(slab);
+
+		sc.slabPtr = slab;
+		sc.slabEnd = slab + (SlabSize / classSize) * classSize;
+		return true;
+	}
+
+private:
+	std::array<SizeClass, NumClasses> classes = {};
+	std::vector<uint8_t*> slabs;
+};
+
 template<size_t S> struct DynMemPool {
 public:
 	void* allocMem(size_t size) {
@@ -71,6 +71,13 @@ public:
 	virtual void Close(bool flush = false) = 0;
 	virtual void SetLossFactor(int factor) = 0;
 
+	/**
+	 * @brief start compressing outgoing data (if configured)
+	 * Only call this once the other side is known to run a compatible
+	 * engine, i.e. after its connection attempt has been accepted.
+	 */
+	virtual void EnableCompression() {}
+
 	/**
 	 * @brief update internals
 	 * Check for unack'd packets, timeout etc.
@@ -1,19 +1,131 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include <string.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 
 #include "RawPacket.h"
 
 #include "System/Log/ILog.h"
+#include "System/Threading/SpringThreading.h"
 
 namespace netcode
 {
 
+class PacketPool
+{
+public:
+	// block sizes are MIN_BLOCK_SIZE << sizeClass, i.e. 32 to 4096 bytes
+	static constexpr uint32_t MIN_BLOCK_SIZE = 32;
+	static constexpr uint32_t NUM_SIZE_CLASSES = 8;
+	static constexpr uint32_t MAX_BLOCK_SIZE = MIN_BLOCK_SIZE << (NUM_SIZE_CLASSES - 1);
+	static constexpr uint32_t SLAB_SIZE = 64 * 1024;
+
+	static PacketPool& GetInstance() {
+		// never destroyed; packets may be released during static deinitialization
+		static PacketPool* pool = new PacketPool();
+		return *pool;
+	}
+
+	uint8_t* Alloc(uint32_t size) {
+		stats.numAllocs.fetch_add(1, std::memory_order_relaxed);
+		stats.numLiveBuffers.fetch_add(1, std::memory_order_relaxed);
+
+		if (size > MAX_BLOCK_SIZE) {
+			stats.numHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+			return (new uint8_t[size]);
+		}
+
+		const uint32_t sizeClass = GetSizeClass(size);
+
+		std::lock_guard<spring::spinlock> lock(mutex);
+		std::vector<uint8_t*>& blocks = freeBlocks[sizeClass];
+
+		if (blocks.empty())
+			AllocSlab(sizeClass);
+
+		uint8_t* block = blocks.back();
+		blocks.pop_back();
+
+		stats.numPoolAllocs.fetch_add(1, std::memory_order_relaxed);
+		return block;
+	}
+
+	void Free(uint8_t* data, uint32_t size) {
+		stats.numLiveBuffers.fetch_sub(1, std::memory_order_relaxed);
+
+		if (size > MAX_BLOCK_SIZE) {
+			delete[] data;
+			return;
+		}
+
+		std::lock_guard<spring::spinlock> lock(mutex);
+		freeBlocks[GetSizeClass(size)].push_back(data);
+	}
+
+	RawPacket::PoolStats GetStats() const {
+		RawPacket::PoolStats ret;
+		ret.numAllocs = stats.numAllocs.load(std::memory_order_relaxed);
+		ret.numPoolAllocs = stats.numPoolAllocs.load(std::memory_order_relaxed);
+		ret.numHeapAllocs = stats.numHeapAllocs.load(std::memory_order_relaxed);
+		ret.numSlabBytes = stats.numSlabBytes.load(std::memory_order_relaxed);
+		ret.numLiveBuffers = stats.numLiveBuffers.load(std::memory_order_relaxed);
+		return ret;
+	}
+
+private:
+	static uint32_t GetSizeClass(uint32_t size) {
+		uint32_t sizeClass = 0;
+
+		while ((MIN_BLOCK_SIZE << sizeClass) < size)
+			sizeClass++;
+
+		return sizeClass;
+	}
+
+	// called with <mutex> held
+	void AllocSlab(uint32_t sizeClass) {
+		const uint32_t blockSize = MIN_BLOCK_SIZE << sizeClass;
+		const uint32_t numBlocks = SLAB_SIZE / blockSize;
+
+		slabs.emplace_back(new uint8_t[SLAB_SIZE]);
+		freeBlocks[sizeClass].reserve(freeBlocks[sizeClass].size() + numBlocks);
+
+		for (uint32_t i = 0; i < numBlocks; i++) {
+			freeBlocks[sizeClass].push_back(slabs.back().get() + i * blockSize);
+		}
+
+		stats.numSlabBytes.fetch_add(SLAB_SIZE, std::memory_order_relaxed);
+	}
+
+private:
+	spring::spinlock mutex;
+
+	std::array<std::vector<uint8_t*>, NUM_SIZE_CLASSES> freeBlocks;
+	std::vector< std::unique_ptr<uint8_t[]> > slabs;
+
+	struct {
+		std::atomic<uint64_t> numAllocs = {0};
+		std::atomic<uint64_t> numPoolAllocs = {0};
+		std::atomic<uint64_t> numHeapAllocs = {0};
+		std::atomic<uint64_t> numSlabBytes = {0};
+		std::atomic<uint64_t> numLiveBuffers = {0};
+	} stats;
+};
+
+
+uint8_t* RawPacket::AllocData(uint32_t size) { return (PacketPool::GetInstance().Alloc(size)); }
+void RawPacket::FreeData(uint8_t* data, uint32_t size) { PacketPool::GetInstance().Free(data, size); }
+RawPacket::PoolStats RawPacket::GetPoolStats() { return (PacketPool::GetInstance().GetStats()); }
+
+
 RawPacket::RawPacket(const uint8_t* const tdata, const uint32_t newLength): length(newLength)
 {
 	if (length > 0) {
-		data = new uint8_t[length];
+		data = AllocData(length);
 		memcpy(data, tdata, length);
 	} else {
 		LOG_L(L_ERROR, "[%s] tried to pack a zero-length packet", __func__);
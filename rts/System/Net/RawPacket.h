@@ -40,7 +40,7 @@ public:
 		if (length == 0)
 			return;
 
-		data = new uint8_t[length];
+		data = AllocData(length);
 	}
 
 	RawPacket(const uint32_t length, uint8_t msgID): RawPacket(length) {
@@ -117,12 +117,31 @@ public:
 		if (length == 0)
 			return;
 
-		delete[] data;
+		FreeData(data, length);
 		data = nullptr;
 
 		length = 0;
 	}
 
+
+	struct PoolStats {
+		uint64_t numAllocs = 0;
+		uint64_t numPoolAllocs = 0;
+		uint64_t numHeapAllocs = 0;
+		uint64_t numSlabBytes = 0;
+		uint64_t numLiveBuffers = 0;
+	};
+
+	/**
+	 * Packet payloads are served from a shared pool of fixed-size blocks
+	 * (carved out of larger slabs) to keep the allocator out of the hot
+	 * send/receive paths; only oversized payloads hit the heap directly.
+	 * Safe to call from any thread.
+	 */
+	static uint8_t* AllocData(uint32_t size);
+	static void FreeData(uint8_t* data, uint32_t size);
+	static PoolStats GetPoolStats();
+
 public:
 	uint8_t id = 0;
 	uint8_t* data = nullptr;
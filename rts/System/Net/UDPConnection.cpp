@@ -3,6 +3,8 @@
 #include "UDPConnection.h"
 
 #include <cinttypes>
+#include <cstring>
+#include <zlib.h>
 
 
 #include "Socket.h"
@@ -27,6 +29,8 @@ using namespace asio;
 static constexpr unsigned udpMaxPacketSize = 4096;
 static constexpr int maxChunkSize = 254;
 static constexpr int chunksPerSec = 30;
+/// smaller batches are sent raw, a sync-flush alone costs 4-5 bytes
+static constexpr unsigned minCompressSize = 32;
 
 
 
@@ -96,8 +100,8 @@ public:
 		pos += sizeof(t);
 	}
 
-	void Unpack(std::vector<std::uint8_t>& t, unsigned unpackLength) {
-		std::copy(data + pos, data + pos + unpackLength, std::back_inserter(t));
+	void Unpack(std::uint8_t* t, unsigned unpackLength) {
+		std::memcpy(t, data + pos, unpackLength);
 		pos += unpackLength;
 	}
 
@@ -125,8 +129,8 @@ public:
 		*reinterpret_cast<T*>(&data[pos]) = t;
 	}
 
-	void Pack(std::vector<std::uint8_t>& _data) {
-		std::copy(_data.begin(), _data.end(), std::back_inserter(data));
+	void Pack(const std::uint8_t* _data, unsigned length) {
+		data.insert(data.end(), _data, _data + length);
 	}
 
 private:
@@ -140,8 +144,11 @@ void Chunk::UpdateChecksum(CRC& crc) const {
 	crc << chunkNumber;
 	crc << (unsigned int)chunkSize;
 
-	if (!data.empty()) {
-		crc.Update(&data[0], data.size());
+	if (compressed)
+		crc << compressedFlag;
+
+	if (chunkSize > 0) {
+		crc.Update(data.data(), chunkSize);
 	}
 }
 
@@ -171,15 +178,18 @@ Packet::Packet(const unsigned char* data, unsigned length)
 	chunks.reserve(buf.Remaining() / Chunk::headerSize);
 
 	while (buf.Remaining() > Chunk::headerSize) {
-		ChunkPtr temp(new Chunk);
+		ChunkPtr temp = std::make_shared<Chunk>();
 		buf.Unpack(temp->chunkNumber);
 		buf.Unpack(temp->chunkSize);
 
+		temp->compressed = ((static_cast<std::uint32_t>(temp->chunkNumber) & Chunk::compressedFlag) != 0);
+		temp->chunkNumber = static_cast<std::int32_t>(static_cast<std::uint32_t>(temp->chunkNumber) & ~Chunk::compressedFlag);
+
 		// defective, ignore
-		if (buf.Remaining() < temp->chunkSize)
+		if (buf.Remaining() < temp->chunkSize || temp->chunkSize > Chunk::maxSize)
 			break;
 
-		buf.Unpack(temp->data, temp->chunkSize);
+		buf.Unpack(temp->data.data(), temp->chunkSize);
 		chunks.push_back(temp);
 	}
 }
@@ -219,12 +229,15 @@ void Packet::Serialize(std::vector<std::uint8_t>& data)
 	buf.Pack(lastContinuous);
 	buf.Pack(nakType);
 	buf.Pack(checksum);
-	buf.Pack(naks);
+	buf.Pack(naks.data(), naks.size());
 
 	for (auto ci = chunks.begin(); ci != chunks.end(); ++ci) {
-		buf.Pack((*ci)->chunkNumber);
+		const std::uint32_t flags = (*ci)->compressed? Chunk::compressedFlag: 0;
+		std::int32_t chunkNumber = static_cast<std::int32_t>(static_cast<std::uint32_t>((*ci)->chunkNumber) | flags);
+
+		buf.Pack(chunkNumber);
 		buf.Pack((*ci)->chunkSize);
-		buf.Pack((*ci)->data);
+		buf.Pack((*ci)->data.data(), (*ci)->chunkSize);
 	}
 }
 
@@ -304,6 +317,12 @@ void UDPConnection::Init()
 	recvOverhead = 0;
 
 	resentChunks = 0;
+	sentChunks = 0;
+	recvChunks = 0;
+	sentRawBytes = 0;
+	sentCompressedBytes = 0;
+	recvRawBytes = 0;
+	recvCompressedBytes = 0;
 	sentPackets = 0;
 	recvPackets = 0;
 	droppedChunks = 0;
@@ -313,6 +332,7 @@ void UDPConnection::Init()
 	muted = true;
 	closed = false;
 	resend = false;
+	inflateFailed = false;
 
 	#ifndef UNIT_TEST
 	logMessages = configHandler->GetBool("UDPConnectionLogDebugMessages");
@@ -344,6 +364,11 @@ UDPConnection::~UDPConnection()
 	waitingPackets.clear();
 
 	Flush(true);
+
+	if (deflateStream != nullptr)
+		deflateEnd(deflateStream.get());
+	if (inflateStream != nullptr)
+		inflateEnd(inflateStream.get());
 }
 
 void UDPConnection::SendData(std::shared_ptr<const RawPacket> pkt)
@@ -479,7 +504,7 @@ void UDPConnection::UpdateWaitingPackets()
 {
 	const auto beg = waitingPackets.begin();
 	const auto end = waitingPackets.end();
-	const auto pos = std::remove_if(beg, end, [](const std::pair<int, RawPacket>& p) { return ((p.second).length == 0); });
+	const auto pos = std::remove_if(beg, end, [](const std::pair<int, ChunkPtr>& p) { return (p.second == nullptr); });
 
 	// erase processed packets
 	waitingPackets.erase(pos, end);
@@ -536,7 +561,10 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 //	if (EMULATE_PACKET_LOSS(lossCounter))
 //		return;
 
-	if (incoming.GetChecksum() != incoming.checksum) {
+	if (inflateFailed)
+		return;
+
+	if (!incoming.checksumVerified && incoming.GetChecksum() != incoming.checksum) {
 		LOG_L(L_ERROR, "\t[%s] discarding incoming corrupted packet: CRC %d, LEN %d", __func__, incoming.checksum, incoming.GetSize());
 		return;
 	}
@@ -600,7 +628,8 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 			continue;
 		}
 
-		waitingPackets.emplace_back(c->chunkNumber, RawPacket(&c->data[0], c->data.size()));
+		waitingPackets.emplace_back(c->chunkNumber, c);
+		recvChunks += 1;
 		incomingChunkNums.insert(c->chunkNumber);
 	}
 
@@ -608,7 +637,7 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 	using P = decltype(waitingPackets)::value_type;
 
 	const auto cmpPred = [](const P& a, const P& b) { return (a.first < b.first); };
-	const auto binFind = [&](int cn) { return std::lower_bound(waitingPackets.begin(), waitingPackets.end(), P{cn, RawPacket{}}, cmpPred); };
+	const auto binFind = [&](int cn) { return std::lower_bound(waitingPackets.begin(), waitingPackets.end(), P{cn, nullptr}, cmpPred); };
 
 	std::sort(waitingPackets.begin(), waitingPackets.end(), cmpPred);
 
@@ -624,13 +653,24 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 			fragmentBuffer.Delete();
 		}
 
-		std::copy(wpi->second.data, wpi->second.data + wpi->second.length, std::back_inserter(waitBuffer));
+		if (wpi->second->compressed) {
+			if (!InflateChunk(*wpi->second, waitBuffer)) {
+				// nothing the peer sends from here on can be decoded, and
+				// the fragment prefix must not be parsed on its own either
+				LOG_L(L_ERROR, "\t[%s] undecodable compressed chunk %d, dropping connection", __func__, wpi->first);
+				inflateFailed = true;
+				waitBuffer.clear();
+				break;
+			}
+		} else {
+			waitBuffer.insert(waitBuffer.end(), wpi->second->data.data(), wpi->second->data.data() + wpi->second->chunkSize);
+		}
 
 		incomingChunkNums.erase(wpi->first);
 		// waitingPackets.erase(wpi);
 
 		// mark as processed
-		(wpi->second).Delete();
+		(wpi->second).reset();
 
 		// next expected chunk-number
 		lastInOrder++;
@@ -714,7 +754,9 @@ void UDPConnection::Flush(const bool forced)
 	}
 
 	if (forced || (!waitMore && outgoingLength > requiredLength)) {
-		std::uint8_t buffer[udpMaxPacketSize];
+		// payloads are copied once, straight into the chunk that will carry
+		// them (or into the batch that is compressed at the end)
+		ChunkPtr chunk;
 		unsigned pos = 0;
 
 		// Manually fragment packets to respect configured UDP_MTU.
@@ -723,6 +765,14 @@ void UDPConnection::Flush(const bool forced)
 		bool partialPacket = false;
 		bool sendMore = true;
 
+		// while compressing, the whole batch is collected and chunked at the end
+		const bool compress = (deflateStream != nullptr);
+
+		// bytes of the front packet that went into earlier chunks; a packet
+		// is always chunked completely within one call (partialPacket forces
+		// sendMore), so this never has to survive across Flush calls
+		unsigned packetOffset = 0;
+
 		do {
 			sendMore  = (outgoing.GetAverage(true) <= globalConfig.linkOutgoingBandwidth);
 			sendMore |= ((globalConfig.linkOutgoingBandwidth <= 0) || partialPacket || forced);
@@ -737,30 +787,45 @@ void UDPConnection::Flush(const bool forced)
 					);
 					outgoingData.pop_front();
 				} else {
-					const unsigned numBytes = std::min((unsigned)maxChunkSize - pos, packet->length);
+					const unsigned numBytes = std::min((unsigned)maxChunkSize - pos, packet->length - packetOffset);
+
+					const std::uint8_t* packetData = packet->data + packetOffset;
 
 					assert(packet->length > 0);
-					memcpy(buffer + pos, packet->data, numBytes);
+
+					if (compress) {
+						compressBuffer.insert(compressBuffer.end(), packetData, packetData + numBytes);
+					} else {
+						if (chunk == nullptr)
+							chunk = std::make_shared<Chunk>();
+
+						memcpy(chunk->data.data() + pos, packetData, numBytes);
+					}
 
 					pos += numBytes;
 					sentOverhead += Packet::headerSize;
 
 					outgoing.DataSent(numBytes, true);
 
-					if ((partialPacket = (numBytes != packet->length))) {
-						// partially transfered
-						packet.reset(new RawPacket(packet->data + numBytes, packet->length - numBytes));
+					if ((partialPacket = ((packetOffset += numBytes) != packet->length))) {
+						// partially transfered, continue at packetOffset
 					} else {
 						// full packet copied
 						outgoingData.pop_front();
+						packetOffset = 0;
 					}
 				}
 			}
 			if ((pos > 0) && (outgoingData.empty() || (pos == maxChunkSize) || !sendMore)) {
-				CreateChunk(buffer, pos, currentPacketChunkNum++);
+				if (!compress)
+					AddChunk(std::move(chunk), pos, currentPacketChunkNum++);
+
 				pos = 0;
 			}
 		} while (!outgoingData.empty() && sendMore);
+
+		if (compress)
+			FlushCompressedChunks();
 	}
 
 	SendIfNecessary(forced);
@@ -768,6 +833,9 @@ void UDPConnection::Flush(const bool forced)
 
 bool UDPConnection::CheckTimeout(int seconds, bool initial) const {
 
+	if (inflateFailed)
+		return true;
+
 	int timeout;
 
 	if (seconds == 0) {
@@ -809,14 +877,25 @@ std::string UDPConnection::Statistics() const
 		"\t{%.3fx, %.3fx} relative protocol overhead {up, down}\n",
 		"\t%u incoming chunks dropped, %u outgoing chunks resent\n",
 		"\t%u incoming chunks processed\n",
+		"\t%u chunks created, %u received\n",
+		"\t{%u, %u} payload bytes compressed to {%u, %u} ({%.3fx, %.3fx}) {up, down}\n",
+		"\t%" PRIu64 " packet buffers allocated (%" PRIu64 " pooled, %" PRIu64 " heap), %" PRIu64 " live, %" PRIu64 " KB in slabs\n",
 	};
 
+	const RawPacket::PoolStats poolStats = RawPacket::GetPoolStats();
+
 	std::string msg = "[UDPConnection::Statistics]\n";
 	msg += spring::format(fmts[0], dataSent, sentPackets, spring::SafeDivide(dataSent * 1.0f, sentPackets * 1.0f));
 	msg += spring::format(fmts[1], dataRecv, recvPackets, spring::SafeDivide(dataRecv * 1.0f, recvPackets * 1.0f));
 	msg += spring::format(fmts[2], spring::SafeDivide(sentOverhead * 1.0f, dataSent * 1.0f), spring::SafeDivide(recvOverhead * 1.0f, dataRecv * 1.0f));
 	msg += spring::format(fmts[3], droppedChunks, resentChunks);
 	msg += spring::format(fmts[4], lastInOrder + 1);
+	msg += spring::format(fmts[5], sentChunks, recvChunks);
+	msg += spring::format(fmts[6],
+		sentRawBytes, recvRawBytes, sentCompressedBytes, recvCompressedBytes,
+		spring::SafeDivide(sentCompressedBytes * 1.0f, sentRawBytes * 1.0f), spring::SafeDivide(recvCompressedBytes * 1.0f, recvRawBytes * 1.0f)
+	);
+	msg += spring::format(fmts[7], poolStats.numAllocs, poolStats.numPoolAllocs, poolStats.numHeapAllocs, poolStats.numLiveBuffers, poolStats.numSlabBytes / 1024);
 	return msg;
 }
 
@@ -832,17 +911,132 @@ void UDPConnection::SetMTU(unsigned mtu2)
 	}
 }
 
-void UDPConnection::CreateChunk(const unsigned char* data, const unsigned length, const int packetNum)
+void UDPConnection::CreateChunk(const unsigned char* data, const unsigned length, const int packetNum, bool compressed)
+{
+	assert((length > 0) && (length < 255));
+	ChunkPtr buf = std::make_shared<Chunk>();
+	std::memcpy(buf->data.data(), data, length);
+	AddChunk(std::move(buf), length, packetNum, compressed);
+}
+void UDPConnection::AddChunk(ChunkPtr&& chunk, const unsigned length, const int packetNum, bool compressed)
 {
 	assert((length > 0) && (length < 255));
-	ChunkPtr buf(new Chunk);
-	buf->chunkNumber = packetNum;
-	buf->chunkSize = length;
-	std::copy(data, data + length, std::back_inserter(buf->data));
-	newChunks.push_back(buf);
+	chunk->chunkNumber = packetNum;
+	chunk->chunkSize = length;
+	chunk->compressed = compressed;
+	newChunks.push_back(std::move(chunk));
+	sentChunks += 1;
 	lastChunkCreatedTime = spring_gettime();
 }
 
+void UDPConnection::CreateChunks(const unsigned char* data, const unsigned length, bool compressed)
+{
+	for (unsigned pos = 0; pos < length; pos += maxChunkSize) {
+		CreateChunk(data + pos, std::min(length - pos, unsigned(maxChunkSize)), currentPacketChunkNum++, compressed);
+	}
+}
+
+void UDPConnection::FlushCompressedChunks()
+{
+	if (compressBuffer.empty())
+		return;
+
+	// data that bypasses the deflate stream is also not fed to the peer's
+	// inflate stream, so tiny batches can go out raw without breaking it
+	if (compressBuffer.size() < minCompressSize) {
+		CreateChunks(compressBuffer.data(), compressBuffer.size(), false);
+		compressBuffer.clear();
+		return;
+	}
+
+	z_stream_s& strm = *deflateStream;
+
+	deflateBuffer.clear();
+
+	strm.next_in = compressBuffer.data();
+	strm.avail_in = compressBuffer.size();
+
+	int ret = Z_OK;
+
+	// Z_SYNC_FLUSH makes everything decodable on the other side once the last chunk arrives
+	do {
+		const size_t pos = deflateBuffer.size();
+
+		deflateBuffer.resize(pos + std::max(compressBuffer.size(), size_t(256)));
+
+		strm.next_out = deflateBuffer.data() + pos;
+		strm.avail_out = deflateBuffer.size() - pos;
+
+		ret = deflate(&strm, Z_SYNC_FLUSH);
+
+		deflateBuffer.resize(deflateBuffer.size() - strm.avail_out);
+	} while (ret == Z_OK && strm.avail_out == 0);
+
+	if ((ret != Z_OK && ret != Z_BUF_ERROR) || strm.avail_in != 0) {
+		LOG_L(L_ERROR, "[UDPConnection::%s] deflate failed (%d), falling back to uncompressed chunks", __func__, ret);
+
+		// the peer never sees this batch in its inflate stream, so just stop compressing
+		deflateEnd(deflateStream.get());
+		deflateStream.reset();
+
+		CreateChunks(compressBuffer.data(), compressBuffer.size(), false);
+		compressBuffer.clear();
+		return;
+	}
+
+	sentRawBytes += compressBuffer.size();
+	sentCompressedBytes += deflateBuffer.size();
+
+	CreateChunks(deflateBuffer.data(), deflateBuffer.size(), true);
+	compressBuffer.clear();
+}
+
+bool UDPConnection::InflateChunk(const Chunk& chunk, std::vector<std::uint8_t>& outBuffer)
+{
+	if (inflateStream == nullptr) {
+		inflateStream = std::make_unique<z_stream_s>();
+
+		if (inflateInit2(inflateStream.get(), -MAX_WBITS) != Z_OK) {
+			inflateStream.reset();
+			return false;
+		}
+
+		// the peer compresses, follow suit if we are allowed to
+		EnableCompression();
+	}
+
+	z_stream_s& strm = *inflateStream;
+
+	strm.next_in = const_cast<Bytef*>(chunk.data.data());
+	strm.avail_in = chunk.chunkSize;
+
+	const size_t outSize = outBuffer.size();
+
+	int ret = Z_OK;
+
+	do {
+		const size_t pos = outBuffer.size();
+
+		outBuffer.resize(pos + 1024);
+
+		strm.next_out = outBuffer.data() + pos;
+		strm.avail_out = 1024;
+
+		ret = inflate(&strm, Z_SYNC_FLUSH);
+
+		outBuffer.resize(outBuffer.size() - strm.avail_out);
+	} while (ret == Z_OK && strm.avail_out == 0);
+
+	if (ret != Z_OK && ret != Z_BUF_ERROR) {
+		outBuffer.resize(outSize);
+		return false;
+	}
+
+	recvCompressedBytes += chunk.chunkSize;
+	recvRawBytes += (outBuffer.size() - outSize);
+	return true;
+}
+
 void UDPConnection::SendIfNecessary(bool flushed)
 {
 	const spring_time curTime = spring_gettime();
@@ -1142,6 +1336,19 @@ void UDPConnection::Close(bool flush) {
 	closed = true;
 }
 
+void UDPConnection::EnableCompression() {
+	if (deflateStream != nullptr || globalConfig.networkCompressionLevel <= 0)
+		return;
+
+	deflateStream = std::make_unique<z_stream_s>();
+
+	// raw deflate; chunks already carry their own checksums
+	if (deflateInit2(deflateStream.get(), globalConfig.networkCompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		LOG_L(L_ERROR, "[UDPConnection::%s] could not initialize deflate stream", __func__);
+		deflateStream.reset();
+	}
+}
+
 void UDPConnection::SetLossFactor(int factor) {
 	netLossFactor = factor;
 	netLossFactor = std::max(netLossFactor, int(MIN_LOSS_FACTOR));
@@ -4,6 +4,7 @@
 #define _UDP_CONNECTION_H
 
 #include <asio/ip/udp.hpp>
+#include <array>
 #include <memory>
 #include <deque>
 
@@ -12,6 +13,7 @@
 #include "System/UnorderedSet.hpp"
 
 class CRC;
+struct z_stream_s;
 
 
 namespace netcode {
@@ -29,13 +31,17 @@ namespace netcode {
 class Chunk
 {
 public:
-	unsigned GetSize() const { return (data.size() + headerSize); }
+	unsigned GetSize() const { return (chunkSize + headerSize); }
 	void UpdateChecksum(CRC& crc) const;
 	static constexpr unsigned maxSize = 254;
 	static constexpr unsigned headerSize = 5;
+	/// set on the wire in chunkNumber for chunks carrying compressed data
+	static constexpr std::uint32_t compressedFlag = 1u << 31;
 	std::int32_t chunkNumber;
 	std::uint8_t chunkSize;
-	std::vector<std::uint8_t> data;
+	bool compressed = false;
+	/// payload is stored inline, make_shared'ing a chunk is its only allocation
+	std::array<std::uint8_t, maxSize> data;
 };
 typedef std::shared_ptr<Chunk> ChunkPtr;
 
@@ -61,6 +67,8 @@ public:
 	/// if > 0, x = size of naks
 	std::int8_t nakType;
 	std::uint8_t checksum;
+	/// set once <checksum> has been validated (by the listener's receive thread)
+	bool checksumVerified = false;
 
 	std::vector<std::uint8_t> naks;
 	std::vector<ChunkPtr> chunks;
@@ -131,6 +139,7 @@ public:
 	void Unmute() override { muted = false; }
 	void Close(bool flush) override;
 	void SetLossFactor(int factor) override;
+	void EnableCompression() override;
 
 	const asio::ip::udp::endpoint& GetEndpoint() const { return addr; }
 
@@ -145,7 +154,13 @@ private:
 	void Init();
 
 	/// add header to data and send it
-	void CreateChunk(const unsigned char* data, const unsigned length, const int packetNum);
+	void CreateChunk(const unsigned char* data, const unsigned length, const int packetNum, bool compressed = false);
+	/// same, for a chunk whose payload was already written to <chunk>->data
+	void AddChunk(ChunkPtr&& chunk, const unsigned length, const int packetNum, bool compressed = false);
+	void CreateChunks(const unsigned char* data, const unsigned length, bool compressed);
+	/// compress and chunk everything collected in compressBuffer during Flush
+	void FlushCompressedChunks();
+	bool InflateChunk(const Chunk& chunk, std::vector<std::uint8_t>& outBuffer);
 	void SendIfNecessary(bool flushed);
 	void AckChunks(int lastAck);
 
@@ -179,14 +194,17 @@ private:
 	bool resend;
 	bool sharedSocket;
 	bool logMessages;
+	/// set once a compressed chunk could not be inflated; the stream is then
+	/// out of sync with the peer for good, so the link counts as timed out
+	bool inflateFailed;
 
 	int netLossFactor;
 	int reconnectTime;
 
 	/// outgoing stuff (pure data without header) waiting to be sent
 	std::deque< std::shared_ptr<const RawPacket> > outgoingData;
-	/// packets we have received but not yet read
-	std::vector< std::pair<int, RawPacket> > waitingPackets;
+	/// chunks we have received but not yet read
+	std::vector< std::pair<int, ChunkPtr> > waitingPackets;
 	spring::unordered_set<int> incomingChunkNums;
 
 
@@ -224,6 +242,14 @@ private:
 
 	RawPacket fragmentBuffer;
 
+	/// persistent raw-deflate streams; the history of previously sent data
+	/// serves as dictionary for every new batch
+	std::unique_ptr<z_stream_s> deflateStream;
+	std::unique_ptr<z_stream_s> inflateStream;
+
+	std::vector<std::uint8_t> compressBuffer;
+	std::vector<std::uint8_t> deflateBuffer;
+
 	// Traffic statistics and stuff
 	#ifdef ENABLE_DEBUG_STATS
 	float sumDeltaFramePacketRecvTime;
@@ -241,6 +267,13 @@ private:
 	unsigned int resentChunks;
 	unsigned int droppedChunks;
 
+	/// chunks created for sending and received (each one a single allocation)
+	unsigned int sentChunks, recvChunks;
+
+	/// payload bytes before and after compression, {sent, received}
+	unsigned int sentRawBytes, sentCompressedBytes;
+	unsigned int recvRawBytes, recvCompressedBytes;
+
 	unsigned int sentOverhead, recvOverhead;
 	unsigned int sentPackets, recvPackets;
 
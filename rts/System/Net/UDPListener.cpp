@@ -7,25 +7,52 @@
 #endif
 #include "System/Misc/NonCopyable.h"
 
+#include <atomic>
 #include <memory>
 #include <asio.hpp>
 #include <cinttypes>
 #include <queue>
 
+#ifndef _WIN32
+	#include <sys/select.h>
+	#include <sys/socket.h>
+#endif
+
 
 #include "ProtocolDef.h"
 #include "UDPConnection.h"
 #include "Socket.h"
+#include "System/ConcurrentQueue.h"
 #include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
 #include "System/Platform/errorhandler.h"
 #include "System/StringUtil.h" // for IntToString (header only)
+#include "System/Threading/SpringThreading.h"
 
 
 namespace netcode
 {
 using namespace asio;
 
-UDPListener::UDPListener(int port, const std::string& ip): acceptNewConnections(false)
+struct UDPListener::RecvThread {
+	struct RecvPacket {
+		ip::udp::endpoint endpoint;
+		Packet packet = {-1, 0};
+	};
+
+	spring::thread thread;
+	std::atomic<bool> quit = {false};
+
+	// single producer (the thread), single consumer (Update)
+	moodycamel::ConcurrentQueue<RecvPacket> queue;
+	// large enough for any datagram
+	std::vector<std::uint8_t> buffer = std::vector<std::uint8_t>(65536, 0);
+
+	std::atomic<std::uint32_t> numCorrupt = {0};
+};
+
+
+UDPListener::UDPListener(int port, const std::string& ip, bool recvThreadEnabled): acceptNewConnections(false)
 {
 	// resets socket on any exception
 	const std::string err = TryBindSocket(port, socket, ip);
@@ -37,9 +64,23 @@ UDPListener::UDPListener(int port, const std::string& ip): acceptNewConnections(
 	SetAcceptingConnections(true);
 
 	LOG("[%s] successfully bound socket on port %i", __func__, socket->local_endpoint().port());
+
+	if (!recvThreadEnabled)
+		return;
+
+	recvThread = std::make_unique<RecvThread>();
+	recvThread->thread = spring::thread(&UDPListener::RecvThreadLoop, this);
 }
 
 UDPListener::~UDPListener() {
+	if (recvThread != nullptr) {
+		recvThread->quit = true;
+		recvThread->thread.join();
+
+		if (recvThread->numCorrupt > 0)
+			LOG("[%s] discarded %u corrupted packets", __func__, recvThread->numCorrupt.load());
+	}
+
 	for (const auto& p: dropMap) {
 		LOG("[%s] dropped %lu packets from unknown IP %s", __func__, (unsigned long) p.second, (p.first).c_str());
 	}
@@ -110,78 +151,145 @@ std::string UDPListener::TryBindSocket(int port, std::shared_ptr<asio::ip::udp::
 void UDPListener::Update() {
 	netservice.poll();
 
-	size_t bytesAvailable = 0;
+	if (recvThread != nullptr) {
+		RecvThread::RecvPacket recvPacket;
 
-	while ((bytesAvailable = socket->available()) > 0) {
-		recvBuffer.clear();
-		recvBuffer.resize(bytesAvailable, 0);
+		// datagrams were already read, parsed and checksummed by RecvThreadLoop
+		while (recvThread->queue.try_dequeue(recvPacket)) {
+			ProcessPacket(recvPacket.endpoint, recvPacket.packet);
+		}
+	} else {
+		size_t bytesAvailable = 0;
 
-		ip::udp::endpoint udpEndPoint;
-		asio::ip::udp::socket::message_flags msgFlags = 0;
-		asio::error_code err;
+		while ((bytesAvailable = socket->available()) > 0) {
+			recvBuffer.clear();
+			recvBuffer.resize(bytesAvailable, 0);
 
-		const size_t bytesReceived = socket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
+			ip::udp::endpoint udpEndPoint;
+			asio::ip::udp::socket::message_flags msgFlags = 0;
+			asio::error_code err;
 
-		const auto ci = connMap.find(udpEndPoint);
+			const size_t bytesReceived = socket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
 
-		// known connection but expired
-		if (ci != connMap.end() && ci->second.expired())
-			continue;
+			if (CheckErrorCode(err))
+				break;
 
-		if (CheckErrorCode(err))
-			break;
+			if (bytesReceived < Packet::headerSize)
+				continue;
 
-		if (bytesReceived < Packet::headerSize)
+			Packet data(&recvBuffer[0], bytesReceived);
+			ProcessPacket(udpEndPoint, data);
+		}
+	}
+
+	for (auto i = connMap.cbegin(); i != connMap.cend(); ) {
+		if (i->second.expired()) {
+			LOG_L(L_DEBUG, "[UDPListener::%s] connection closed: [%s]:%i", __func__, i->first.address().to_string().c_str(), i->first.port());
+			i = connMap.erase(i);
 			continue;
+		}
+		i->second.lock()->Update();
+		++i;
+	}
+}
 
-		Packet data(&recvBuffer[0], bytesReceived);
+void UDPListener::ProcessPacket(const ip::udp::endpoint& udpEndPoint, Packet& data) {
+	const auto ci = connMap.find(udpEndPoint);
 
-		if (ci != connMap.end()) {
-			ci->second.lock()->ProcessRawPacket(data);
-			continue;
+	if (ci != connMap.end()) {
+		// known connection but expired
+		if (ci->second.expired())
+			return;
+
+		ci->second.lock()->ProcessRawPacket(data);
+		return;
+	}
+
+
+	// unknown connection but still have the packet, maybe a new client wants to connect from sender's address
+	if (acceptNewConnections && data.lastContinuous == -1 && data.nakType == 0)	{
+		if (!data.chunks.empty() && (*data.chunks.begin())->chunkNumber == 0) {
+			std::shared_ptr<UDPConnection> incoming(new UDPConnection(socket, udpEndPoint));
+			waiting.push(incoming);
+			connMap[udpEndPoint] = incoming;
+			incoming->ProcessRawPacket(data);
 		}
 
+		return;
+	}
+
+
+	const asio::ip::address& senderAddr = udpEndPoint.address();
+	const std::string& senderIP = senderAddr.to_string();
+
+	if (dropMap.find(senderIP) == dropMap.end()) {
+		LOG_L(L_DEBUG, "[UDPListener::%s] dropping packet from unknown IP: [%s]:%i", __func__, senderIP.c_str(), udpEndPoint.port());
+		dropMap[senderIP] = 0;
+	} else {
+		dropMap[senderIP] += 1;
+	}
+
+#ifdef DEBUG
+	std::string conns;
+	for (auto it = connMap.cbegin(); it != connMap.cend(); ++it) {
+		conns += spring::format(" [%s]:%i;", it->first.address().to_string().c_str(),it->first.port());
+	}
+	LOG_L(L_DEBUG, "[UDPListener::%s] open connections: %s", __func__, conns.c_str());
+#endif
+}
 
-		// unknown connection but still have the packet, maybe a new client wants to connect from sender's address
-		if (acceptNewConnections && data.lastContinuous == -1 && data.nakType == 0)	{
-			if (!data.chunks.empty() && (*data.chunks.begin())->chunkNumber == 0) {
-				std::shared_ptr<UDPConnection> incoming(new UDPConnection(socket, udpEndPoint));
-				waiting.push(incoming);
-				connMap[udpEndPoint] = incoming;
-				incoming->ProcessRawPacket(data);
-			}
+void UDPListener::RecvThreadLoop() {
+	// NOTE:
+	//   the asio socket object is not safe for concurrent use and belongs to
+	//   the server thread, whose UDPConnections send through it; this thread
+	//   only reads the native handle, the OS allows one thread to send while
+	//   another receives on the same datagram socket
+	const auto handle = socket->native_handle();
 
+	std::vector<std::uint8_t>& buffer = recvThread->buffer;
+
+	while (!recvThread->quit) {
+		fd_set readSet;
+		FD_ZERO(&readSet);
+		FD_SET(handle, &readSet);
+
+		// block until a datagram arrives, waking up regularly to check for quit
+		timeval timeout = {0, 50 * 1000};
+
+		if (select(int(handle) + 1, &readSet, nullptr, nullptr, &timeout) <= 0)
 			continue;
-		}
 
+		ip::udp::endpoint udpEndPoint;
 
-		const asio::ip::address& senderAddr = udpEndPoint.address();
-		const std::string& senderIP = senderAddr.to_string();
+	#ifdef _WIN32
+		int endPointSize = udpEndPoint.capacity();
+		const int bytesReceived = recvfrom(handle, reinterpret_cast<char*>(buffer.data()), buffer.size(), 0, udpEndPoint.data(), &endPointSize);
+	#else
+		// readable does not guarantee a datagram (e.g. one dropped for a bad UDP checksum)
+		socklen_t endPointSize = udpEndPoint.capacity();
+		const ssize_t bytesReceived = recvfrom(handle, buffer.data(), buffer.size(), MSG_DONTWAIT, udpEndPoint.data(), &endPointSize);
+	#endif
 
-		if (dropMap.find(senderIP) == dropMap.end()) {
-			LOG_L(L_DEBUG, "[UDPListener::%s] dropping packet from unknown IP: [%s]:%i", __func__, senderIP.c_str(), udpEndPoint.port());
-			dropMap[senderIP] = 0;
-		} else {
-			dropMap[senderIP] += 1;
+		if (bytesReceived < 0) {
+			// e.g. ICMP port-unreachable reported by Windows; do not spin on persistent errors
+			spring_msecs(1).sleep(true);
+			continue;
 		}
 
-	#ifdef DEBUG
-		std::string conns;
-		for (auto it = connMap.cbegin(); it != connMap.cend(); ++it) {
-			conns += spring::format(" [%s]:%i;", it->first.address().to_string().c_str(),it->first.port());
-		}
-		LOG_L(L_DEBUG, "[UDPListener::%s] open connections: %s", __func__, conns.c_str());
-	#endif
-	}
+		udpEndPoint.resize(endPointSize);
 
-	for (auto i = connMap.cbegin(); i != connMap.cend(); ) {
-		if (i->second.expired()) {
-			LOG_L(L_DEBUG, "[UDPListener::%s] connection closed: [%s]:%i", __func__, i->first.address().to_string().c_str(), i->first.port());
-			i = connMap.erase(i);
+		if (size_t(bytesReceived) < Packet::headerSize)
+			continue;
+
+		RecvThread::RecvPacket recvPacket = {udpEndPoint, Packet(&buffer[0], bytesReceived)};
+
+		if (recvPacket.packet.GetChecksum() != recvPacket.packet.checksum) {
+			recvThread->numCorrupt += 1;
 			continue;
 		}
-		i->second.lock()->Update();
-		++i;
+
+		recvPacket.packet.checksumVerified = true;
+		recvThread->queue.enqueue(std::move(recvPacket));
 	}
 }
 
@@ -13,6 +13,7 @@
 namespace netcode
 {
 class UDPConnection;
+class Packet;
 
 /**
  * @brief Class for handling Connections on an UDPSocket
@@ -28,8 +29,11 @@ public:
 	 * @brief Open a socket and make it ready for listening
 	 * @param  port the port to bind the socket to
 	 * @param  ip local IP to bind to, or "" for any
+	 * @param  recvThread read, parse and checksum incoming datagrams on a
+	 *         separate thread; Update() then only hands the parsed packets
+	 *         to their connections
 	 */
-	UDPListener(int port, const std::string& ip = "");
+	UDPListener(int port, const std::string& ip = "", bool recvThread = false);
 
 	/**
 	 * @brief close the socket and DELETE all connections
@@ -75,6 +79,12 @@ public:
 	void RejectConnection() { waiting.pop(); }
 	void UpdateConnections(); // Updates connections when the endpoint has been reconnected
 
+private:
+	struct RecvThread;
+
+	void RecvThreadLoop();
+	void ProcessPacket(const asio::ip::udp::endpoint& udpEndPoint, Packet& data);
+
 private:
 	/**
 	 * @brief Do we accept packets from unknown sources?
@@ -92,6 +102,8 @@ private:
 	std::map< std::string, size_t> dropMap;
 
 	std::queue< std::shared_ptr<UDPConnection> > waiting;
+
+	std::unique_ptr<RecvThread> recvThread;
 };
 
 }
@@ -0,0 +1,340 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef RING_DEQUE_H
+#define RING_DEQUE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "System/creg/creg_cond.h"
+
+namespace spring {
+	/**
+	 * Double-ended queue stored in a single contiguous circular buffer
+	 * (capacity is always a power of two), as opposed to std::deque's
+	 * separately allocated blocks. Cheap push/pop at both ends, random
+	 * access and better locality when iterating; insertion and erasure
+	 * in the middle shift elements towards the nearer end.
+	 *
+	 * Slots are always default-constructed, popped elements are reset
+	 * to T{} so any resources they hold are released immediately.
+	 *
+	 * NOTE:
+	 *   unlike std::deque, growing the buffer (pushing into a full queue)
+	 *   invalidates all references to elements, just like std::vector
+	 */
+	template<typename T>
+	class RingDeque {
+	private:
+		template<bool IsConst> class Iterator {
+		public:
+			typedef std::random_access_iterator_tag iterator_category;
+			typedef T value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::conditional_t<IsConst, const T*, T*> pointer;
+			typedef std::conditional_t<IsConst, const T&, T&> reference;
+			typedef std::conditional_t<IsConst, const RingDeque*, RingDeque*> container_pointer;
+
+			Iterator() = default;
+			Iterator(container_pointer c, size_t i): cont(c), idx(i) {}
+			// allow iterator -> const_iterator conversion
+			template<bool C = IsConst, typename = std::enable_if_t<C>>
+			Iterator(const Iterator<false>& it): cont(it.cont), idx(it.idx) {}
+
+			reference operator * () const { return (*cont)[idx]; }
+			pointer operator -> () const { return &(*cont)[idx]; }
+			reference operator [] (difference_type n) const { return (*cont)[idx + n]; }
+
+			Iterator& operator ++ () { ++idx; return *this; }
+			Iterator& operator -- () { --idx; return *this; }
+			Iterator operator ++ (int) { Iterator it = *this; ++idx; return it; }
+			Iterator operator -- (int) { Iterator it = *this; --idx; return it; }
+
+			Iterator& operator += (difference_type n) { idx += n; return *this; }
+			Iterator& operator -= (difference_type n) { idx -= n; return *this; }
+
+			Iterator operator + (difference_type n) const { return {cont, idx + n}; }
+			Iterator operator - (difference_type n) const { return {cont, idx - n}; }
+			friend Iterator operator + (difference_type n, const Iterator& it) { return (it + n); }
+
+			// mixed iterator / const_iterator arithmetic and comparisons
+			template<bool C> difference_type operator - (const Iterator<C>& it) const { return (difference_type(idx) - difference_type(it.idx)); }
+
+			template<bool C> bool operator == (const Iterator<C>& it) const { return (idx == it.idx); }
+			template<bool C> bool operator != (const Iterator<C>& it) const { return (idx != it.idx); }
+			template<bool C> bool operator <  (const Iterator<C>& it) const { return (idx <  it.idx); }
+			template<bool C> bool operator >  (const Iterator<C>& it) const { return (idx >  it.idx); }
+			template<bool C> bool operator <= (const Iterator<C>& it) const { return (idx <= it.idx); }
+			template<bool C> bool operator >= (const Iterator<C>& it) const { return (idx >= it.idx); }
+
+		private:
+			friend class RingDeque;
+			friend class Iterator<!IsConst>;
+
+			container_pointer cont = nullptr;
+			/// logical index, i.e. relative to the queue's front
+			size_t idx = 0;
+		};
+
+	public:
+		typedef T value_type;
+		typedef size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef T& reference;
+		typedef const T& const_reference;
+
+		typedef Iterator<false> iterator;
+		typedef Iterator< true> const_iterator;
+		typedef std::reverse_iterator<iterator> reverse_iterator;
+		typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+		static constexpr size_t MIN_CAPACITY = 8;
+
+	public:
+		RingDeque() = default;
+		RingDeque(const RingDeque& rd) { *this = rd; }
+		RingDeque(RingDeque&& rd) noexcept { *this = std::move(rd); }
+
+		RingDeque& operator = (const RingDeque& rd) {
+			if (this == &rd)
+				return *this;
+
+			clear();
+			reserve(rd.size());
+
+			for (const T& elem: rd) {
+				push_back(elem);
+			}
+
+			return *this;
+		}
+		RingDeque& operator = (RingDeque&& rd) noexcept {
+			slots = std::move(rd.slots);
+			head = rd.head;
+			count = rd.count;
+
+			rd.head = 0;
+			rd.count = 0;
+			return *this;
+		}
+
+		bool empty() const { return (count == 0); }
+		size_t size() const { return count; }
+		size_t capacity() const { return slots.size(); }
+
+		void reserve(size_t n) {
+			if (n > slots.size())
+				Grow(n);
+		}
+
+		void resize(size_t n) {
+			while (count > n)
+				pop_back();
+			while (count < n)
+				push_back(T{});
+		}
+
+		void clear() {
+			for (size_t i = 0; i < count; i++) {
+				Slot(i) = T{};
+			}
+
+			head = 0;
+			count = 0;
+		}
+
+		      T& operator [] (size_t i)       { assert(i < count); return Slot(i); }
+		const T& operator [] (size_t i) const { assert(i < count); return Slot(i); }
+
+		      T& at(size_t i)       { RangeCheck(i); return Slot(i); }
+		const T& at(size_t i) const { RangeCheck(i); return Slot(i); }
+
+		      T& front()       { assert(count > 0); return Slot(0); }
+		const T& front() const { assert(count > 0); return Slot(0); }
+		      T& back()        { assert(count > 0); return Slot(count - 1); }
+		const T& back()  const { assert(count > 0); return Slot(count - 1); }
+
+		iterator       begin()       { return {this,     0}; }
+		const_iterator begin() const { return {this,     0}; }
+		iterator       end()         { return {this, count}; }
+		const_iterator end()   const { return {this, count}; }
+
+		const_iterator cbegin() const { return begin(); }
+		const_iterator cend()   const { return end(); }
+
+		reverse_iterator       rbegin()       { return reverse_iterator(end()); }
+		const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+		reverse_iterator       rend()         { return reverse_iterator(begin()); }
+		const_reverse_iterator rend()   const { return const_reverse_iterator(begin()); }
+
+
+		void push_back(const T& v) {
+			// copy first if growing, <v> might refer to one of our own elements
+			if (count == slots.size()) {
+				emplace_back(v);
+				return;
+			}
+
+			Slot(count++) = v;
+		}
+		void push_back(T&& v) { emplace_back(std::move(v)); }
+
+		void push_front(const T& v) {
+			if (count == slots.size()) {
+				emplace_front(v);
+				return;
+			}
+
+			head = (head - 1) & (slots.size() - 1);
+			count += 1;
+
+			Slot(0) = v;
+		}
+		void push_front(T&& v) { emplace_front(std::move(v)); }
+
+		template<typename... A> T& emplace_back(A&&... args) {
+			// construct first, <args> might refer to one of our own elements
+			T v(std::forward<A>(args)...);
+
+			if (count == slots.size())
+				Grow(count + 1);
+
+			T& slot = Slot(count++);
+			slot = std::move(v);
+			return slot;
+		}
+
+		template<typename... A> T& emplace_front(A&&... args) {
+			T v(std::forward<A>(args)...);
+
+			if (count == slots.size())
+				Grow(count + 1);
+
+			head = (head - 1) & (slots.size() - 1);
+			count += 1;
+
+			T& slot = Slot(0);
+			slot = std::move(v);
+			return slot;
+		}
+
+		void pop_back() {
+			assert(count > 0);
+			Slot(--count) = T{};
+		}
+
+		void pop_front() {
+			assert(count > 0);
+			Slot(0) = T{};
+
+			head = (head + 1) & (slots.size() - 1);
+			count -= 1;
+		}
+
+
+		iterator insert(const_iterator pos, const T& v) {
+			const size_t idx = pos.idx;
+
+			assert(idx <= count);
+
+			// shift whichever side of <pos> is shorter
+			if (idx < (count - idx)) {
+				push_front(v);
+				std::rotate(begin(), begin() + 1, begin() + idx + 1);
+			} else {
+				push_back(v);
+				std::rotate(begin() + idx, end() - 1, end());
+			}
+
+			return (begin() + idx);
+		}
+
+		iterator erase(const_iterator pos) { return (erase(pos, pos + 1)); }
+		iterator erase(const_iterator first, const_iterator last) {
+			const size_t idx = first.idx;
+			const size_t num = last.idx - first.idx;
+
+			assert(first.idx <= last.idx);
+			assert(last.idx <= count);
+
+			if (num == 0)
+				return (begin() + idx);
+
+			if (idx < (count - last.idx)) {
+				// fewer elements in front of the range
+				std::move_backward(begin(), begin() + idx, begin() + last.idx);
+
+				for (size_t n = 0; n < num; n++) {
+					pop_front();
+				}
+			} else {
+				std::move(begin() + last.idx, end(), begin() + idx);
+
+				for (size_t n = 0; n < num; n++) {
+					pop_back();
+				}
+			}
+
+			return (begin() + idx);
+		}
+
+	private:
+		T& Slot(size_t i) { return slots[(head + i) & (slots.size() - 1)]; }
+		const T& Slot(size_t i) const { return slots[(head + i) & (slots.size() - 1)]; }
+
+		void RangeCheck(size_t i) const {
+			if (i < count)
+				return;
+
+			throw std::out_of_range("[RingDeque::at] index out of range");
+		}
+
+		void Grow(size_t minCapacity) {
+			size_t newCapacity = std::max(MIN_CAPACITY, slots.size());
+
+			while (newCapacity < minCapacity)
+				newCapacity <<= 1;
+
+			if (newCapacity == slots.size())
+				return;
+
+			std::vector<T> newSlots(newCapacity);
+
+			for (size_t i = 0; i < count; i++) {
+				newSlots[i] = std::move(Slot(i));
+			}
+
+			slots = std::move(newSlots);
+			head = 0;
+		}
+
+	private:
+		std::vector<T> slots;
+
+		/// physical index of the front element
+		size_t head = 0;
+		size_t count = 0;
+	};
+}
+
+
+#ifdef USING_CREG
+
+namespace creg
+{
+	template<typename T>
+	struct DeduceType<spring::RingDeque<T>> {
+		static std::unique_ptr<IType> Get() {
+			return std::unique_ptr<IType>(new DynamicArrayType<spring::RingDeque<T> >());
+		}
+	};
+}
+
+#endif // USING_CREG
+
+#endif // RING_DEQUE_H
@@ -144,6 +144,7 @@ DEFINE_string_EX(write_dir,          "write-dir",          "",    "Specify where
 DEFINE_string   (game,                                     "",    "Specify the game that will be instantly loaded");
 DEFINE_string   (map,                                      "",    "Specify the map that will be instantly loaded");
 DEFINE_string   (menu,                                     "",    "Specify a lua menu archive to be used by spring");
+DEFINE_string   (benchmark,                                "",    "Play the given demo back at unlimited speed and write per-frame simulation timings to <benchmark>.csv and <benchmark>.json (meant for the headless build)");
 DEFINE_string   (name,                                     "",    "Set your player name");
 DEFINE_bool     (oldmenu,                                  false, "Start the old menu");
 
@@ -570,6 +571,7 @@ CGameController* SpringApp::LoadDemoFile(const std::string& demoFile)
 {
 	clientSetup->isHost = true;
 	clientSetup->myPlayerName += " (spec)";
+	clientSetup->benchmarkFile = FLAGS_benchmark;
 
 	pregame = new CPreGame(clientSetup);
 	pregame->LoadDemoFile(demoFile);
@@ -9,7 +9,9 @@
 #include "System/Threading/ThreadPool.h"
 
 
-unsigned CSyncChecker::g_checksum;
+std::array<std::uint32_t, SYNC_CATEGORY_COUNT> CSyncChecker::g_checksums;
+unsigned CSyncChecker::g_category = SYNC_CATEGORY_OTHER;
+std::array<CSyncChecker::FrameChecksums, CSyncChecker::HISTORY_SIZE> CSyncChecker::history;
 int CSyncChecker::inSyncedCode;
 
 
@@ -18,4 +20,24 @@ void CSyncChecker::debugSyncCheckThreading()
     assert(ThreadPool::GetThreadNum() == 0);
 }
 
+
+void CSyncChecker::StoreFrameChecksums(int frameNum)
+{
+	FrameChecksums& entry = history[frameNum & (HISTORY_SIZE - 1)];
+
+	entry.frameNum = frameNum;
+	entry.checksums = g_checksums;
+}
+
+bool CSyncChecker::GetFrameChecksums(int frameNum, std::vector<std::uint32_t>& checksums)
+{
+	const FrameChecksums& entry = history[frameNum & (HISTORY_SIZE - 1)];
+
+	if (entry.frameNum != frameNum)
+		return false;
+
+	checksums.assign(entry.checksums.begin(), entry.checksums.end());
+	return true;
+}
+
 #endif // SYNCDEBUG
@@ -3,10 +3,48 @@
 #ifndef SYNCCHECKER_H
 #define SYNCCHECKER_H
 
+/**
+ * Simulation stages that keep a running checksum of their own. The combined
+ * checksum goes out with every sync-response; on a desync the server asks
+ * for the per-stage values to find out which subsystem diverged first.
+ */
+enum SyncCategory {
+	SYNC_CATEGORY_OTHER       = 0, // net-commands, teams, players, ...
+	SYNC_CATEGORY_LUARULES    = 1,
+	SYNC_CATEGORY_MAP         = 2,
+	SYNC_CATEGORY_UNITS       = 3,
+	SYNC_CATEGORY_PATHING     = 4,
+	SYNC_CATEGORY_PROJECTILES = 5,
+	SYNC_CATEGORY_FEATURES    = 6,
+	SYNC_CATEGORY_LOS         = 7,
+	SYNC_CATEGORY_RNG         = 8,
+	SYNC_CATEGORY_COUNT       = 9,
+};
+
+static inline const char* GetSyncCategoryName(unsigned category) {
+	constexpr const char* names[SYNC_CATEGORY_COUNT] = {
+		"other",
+		"luarules",
+		"map",
+		"units",
+		"pathing",
+		"projectiles",
+		"features",
+		"los",
+		"rng",
+	};
+
+	return ((category < SYNC_CATEGORY_COUNT)? names[category]: "unknown");
+}
+
+
 #ifdef SYNCCHECK
 
 #include "System/SpringHash.h"
 
+#include <array>
+#include <cinttypes>
+#include <vector>
 #include <assert.h>
 
 /**
@@ -28,8 +66,8 @@ class CSyncChecker {
 		/**
 		 * Keeps a running checksum over all assignments to synced variables.
 		 */
-		static unsigned GetChecksum() { return g_checksum; }
-		static void NewFrame() { g_checksum = 0xfade1eaf; }
+		static unsigned GetChecksum() { return spring::LiteHash(g_checksums.data(), sizeof(g_checksums), 0); }
+		static void NewFrame() { g_checksums.fill(0xfade1eaf); }
 		static void debugSyncCheckThreading();
 		static void Sync(const void* p, unsigned size) {
 #ifdef DEBUG_SYNC_MT_CHECK
@@ -38,16 +76,50 @@ class CSyncChecker {
 #endif
 			// most common cases first, make it easy for compiler to optimize for it
 			// simple xor is not enough to detect multiple zeroes, e.g.
-			g_checksum = spring::LiteHash(p, size, g_checksum);
-			//LOG("[Sync::Checker] chksum=%u\n", g_checksum);
+			g_checksums[g_category] = spring::LiteHash(p, size, g_checksums[g_category]);
+			//LOG("[Sync::Checker] chksum=%u\n", g_checksums[g_category]);
+		}
+		static void Sync(unsigned category, const void* p, unsigned size) {
+			g_checksums[category] = spring::LiteHash(p, size, g_checksums[category]);
 		}
 
+		/**
+		 * Category that subsequent Sync calls are accounted to.
+		 */
+		static unsigned GetCategory() { return g_category; }
+		static void SetCategory(unsigned category) { assert(category < SYNC_CATEGORY_COUNT); g_category = category; }
+
+		class CategoryScope {
+		public:
+			CategoryScope(unsigned category): prevCategory(GetCategory()) { SetCategory(category); }
+			~CategoryScope() { SetCategory(prevCategory); }
+		private:
+			unsigned prevCategory;
+		};
+
+		/**
+		 * Per-category checksums are remembered for the last HISTORY_SIZE
+		 * frames, long enough to answer a server request for any frame it
+		 * might still be checking.
+		 */
+		static void StoreFrameChecksums(int frameNum);
+		static bool GetFrameChecksums(int frameNum, std::vector<std::uint32_t>& checksums);
+
 	private:
+		static constexpr int HISTORY_SIZE = 1024;
+
+		struct FrameChecksums {
+			int frameNum = -1;
+			std::array<std::uint32_t, SYNC_CATEGORY_COUNT> checksums = {};
+		};
 
 		/**
-		 * The sync checksum
+		 * The sync checksums, one per category
 		 */
-		static unsigned g_checksum;
+		static std::array<std::uint32_t, SYNC_CATEGORY_COUNT> g_checksums;
+		static unsigned g_category;
+
+		static std::array<FrameChecksums, HISTORY_SIZE> history;
 
 		/**
 		 * @brief in synced code
@@ -71,6 +71,13 @@ namespace Sync {
 #  define LEAVE_SYNCED_CODE()
 #endif
 
+// accounts all synced writes in the enclosing scope to SyncCategory <c>
+#ifdef SYNCCHECK
+#  define SYNC_CATEGORY_SCOPE(c) CSyncChecker::CategoryScope syncCategoryScope(c)
+#else
+#  define SYNC_CATEGORY_SCOPE(c)
+#endif
+
 #ifdef SYNCDEBUG
 #  define ASSERT_SYNCED(x) Sync::AssertDebugger(x, "assert(" #x ")")
 #else
@@ -180,6 +180,18 @@ bool CTimeProfiler::UnRegisterTimer(const char* timerName)
 	return true;
 }
 
+std::string CTimeProfiler::GetTimerName(unsigned nameHash)
+{
+	std::lock_guard<HashNamMutexType> lock(hashToNameMutex);
+
+	const auto iter = hashToName.find(nameHash);
+
+	if (iter == hashToName.end())
+		return "";
+
+	return (iter->second);
+}
+
 
 void CTimeProfiler::ResetState() {
 	// grab lock; ThreadPool workers might already be running SCOPED_MT_TIMER
@@ -406,6 +418,18 @@ void CTimeProfiler::AddTimeRaw(
 	}
 }
 
+void CTimeProfiler::GetTimerTotals(std::vector< std::pair<unsigned, spring_time> >& totals) const
+{
+	std::lock_guard<ProfileMutexType> lock(profileMutex);
+
+	totals.clear();
+	totals.reserve(profiles.size());
+
+	for (const auto& profile: profiles) {
+		totals.emplace_back(profile.first, profile.second.total);
+	}
+}
+
 void CTimeProfiler::PrintProfilingInfo() const
 {
 	if (sortedProfiles.empty())
@@ -105,6 +105,7 @@ public:
 
 	static bool RegisterTimer(const char* name);
 	static bool UnRegisterTimer(const char* name);
+	static std::string GetTimerName(unsigned nameHash);
 
 	struct TimeRecord {
 		TimeRecord() {
@@ -187,6 +188,9 @@ public:
 	void SetEnabled(bool b) { enabled = b; }
 	void PrintProfilingInfo() const;
 
+	/// fills <totals> with the accumulated time of each timer (by name-hash)
+	void GetTimerTotals(std::vector< std::pair<unsigned, spring_time> >& totals) const;
+
 	void AddTime(
 		unsigned nameHash,
 		const spring_time startTime,
@@ -11,6 +11,7 @@
 #include "Game/GameData.h"
 #include "Game/GameVersion.h"
 #include "Net/GameServer.h"
+#include "Net/SpectatorRelay.h"
 #include "System/Exceptions.h"
 #include "System/GlobalConfig.h"
 #include "System/GlobalRNG.h"
@@ -47,6 +48,11 @@ DEFINE_bool     (isolation,                            false, "Limit the data-di
 DEFINE_string_EX(isolation_dir,    "isolation-dir",    "",    "Specify the isolation-mode data-dir (see --isolation)");
 DEFINE_bool     (nocolor,                              false, "Disables colorized stdout");
 DEFINE_uint32   (sleeptime,                            1,     "Number of seconds to sleep between game-over checks");
+DEFINE_string   (relay,                                "",    "Instead of hosting a game, relay the game on host:port to spectators");
+DEFINE_uint32   (relayport,                            8453,  "Port the relay accepts spectators on");
+DEFINE_uint32   (relaydelay,                           0,     "Number of seconds the relayed game lags behind the server");
+DEFINE_string   (relayname,                            "relay", "Spectator name the relay joins the server with");
+DEFINE_string   (relaypasswd,                          "",    "Password of the relay's spectator slot on the server");
 
 #ifdef __cplusplus
 extern "C"
@@ -73,7 +79,7 @@ void ParseCmdLine(int argc, char* argv[], std::string& scriptName)
 	if (argc >= 2)
 		scriptName = argv[1];
 
-	if (scriptName.empty() && !FLAGS_list_config_vars) {
+	if (scriptName.empty() && FLAGS_relay.empty() && !FLAGS_list_config_vars) {
 		gflags::ShowUsageWithFlags(argv[0]);
 		exit(1);
 	}
@@ -105,6 +111,39 @@ void ParseCmdLine(int argc, char* argv[], std::string& scriptName)
 
 
 
+int RunRelay()
+{
+	CSpectatorRelay::Settings settings;
+
+	const size_t sepPos = FLAGS_relay.rfind(':');
+
+	settings.hostIP = FLAGS_relay.substr(0, sepPos);
+	settings.hostPort = (sepPos != std::string::npos)? std::atoi(FLAGS_relay.c_str() + sepPos + 1): settings.hostPort;
+	settings.relayPort = FLAGS_relayport;
+	settings.delay = FLAGS_relaydelay;
+	settings.name = FLAGS_relayname;
+	settings.passwd = FLAGS_relaypasswd;
+
+	LOG("starting relay...");
+
+	{
+		CSpectatorRelay relay(settings);
+
+		while (!relay.HasFinished()) {
+			relay.Update();
+			spring_msecs(5).sleep(true);
+		}
+	}
+
+	LOG("exiting");
+	FileSystemInitializer::Cleanup();
+	DataDirLocater::FreeInstance();
+
+	spring_clock::PopTickRate();
+	LOG("exited");
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 	Threading::SetMainThread();
@@ -120,7 +159,7 @@ int main(int argc, char* argv[])
 		std::string scriptText;
 		std::string binaryName = argv[0];
 
-		gflags::SetUsageMessage("Usage: " + binaryName + " [options] path_to_script.txt");
+		gflags::SetUsageMessage("Usage: " + binaryName + " [options] path_to_script.txt\n       " + binaryName + " [options] --relay host:port");
 		gflags::SetVersionString(SpringVersion::GetFull());
 		gflags::ParseCommandLineFlags(&argc, &argv, true);
 		ParseCmdLine(argc, argv, scriptName);
@@ -133,6 +172,10 @@ int main(int argc, char* argv[])
 		CrashHandler::Install();
 
 		LOG("report any errors to Mantis or the forums.");
+
+		if (!FLAGS_relay.empty())
+			return RunRelay();
+
 		LOG("loading script from file: %s", scriptName.c_str());
 
 		// server will take ownership of these
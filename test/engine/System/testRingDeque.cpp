@@ -0,0 +1,123 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/RingDeque.h"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+template<typename A, typename B>
+static bool Equal(const A& a, const B& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	return (std::equal(a.begin(), a.end(), b.begin()) && std::equal(a.rbegin(), a.rend(), b.rbegin()));
+}
+
+
+TEST_CASE("RingDeque")
+{
+	SECTION("push and pop at both ends") {
+		spring::RingDeque<int> rd;
+
+		for (int i = 0; i < 100; i++) {
+			rd.push_back(i);
+			rd.push_front(-i);
+		}
+
+		CHECK(rd.size() == 200);
+		CHECK(rd.front() == -99);
+		CHECK(rd.back() == 99);
+		CHECK(rd[99] == 0);
+		CHECK(rd[100] == 0);
+
+		for (int i = 0; i < 100; i++) {
+			rd.pop_front();
+			rd.pop_back();
+		}
+
+		CHECK(rd.empty());
+		CHECK_THROWS(rd.at(0));
+	}
+
+	SECTION("insert and erase in the middle") {
+		spring::RingDeque<int> rd;
+
+		for (int i = 0; i < 10; i++) {
+			rd.push_back(i);
+		}
+
+		const auto it = rd.insert(rd.begin() + 3, 42);
+
+		CHECK(*it == 42);
+		CHECK(rd[3] == 42);
+		CHECK(rd[4] == 3);
+		CHECK(rd.size() == 11);
+
+		const auto jt = rd.erase(rd.begin() + 2, rd.begin() + 5);
+
+		CHECK(*jt == 4);
+		CHECK(rd.size() == 8);
+		CHECK(rd[1] == 1);
+		CHECK(rd[2] == 4);
+	}
+
+	SECTION("self-referencing push while growing") {
+		spring::RingDeque<int> rd;
+
+		rd.push_back(7);
+
+		for (int i = 0; i < 1000; i++) {
+			rd.push_back(rd.front());
+			rd.push_front(rd.back());
+		}
+
+		CHECK(rd.size() == 2001);
+		CHECK(std::count(rd.begin(), rd.end(), 7) == 2001);
+	}
+
+	SECTION("randomized against std::deque") {
+		std::mt19937 rng(1234);
+		spring::RingDeque<int> rd;
+		std::deque<int> sd;
+
+		for (int n = 0; n < 50000; n++) {
+			const int v = int(rng());
+
+			switch (rng() % 7) {
+				case 0: { rd.push_back(v); sd.push_back(v); } break;
+				case 1: { rd.push_front(v); sd.push_front(v); } break;
+				case 2: { if (!sd.empty()) { rd.pop_back(); sd.pop_back(); } } break;
+				case 3: { if (!sd.empty()) { rd.pop_front(); sd.pop_front(); } } break;
+				case 4: {
+					const size_t i = rng() % (sd.size() + 1);
+					rd.insert(rd.begin() + i, v);
+					sd.insert(sd.begin() + i, v);
+				} break;
+				case 5: {
+					if (sd.empty())
+						break;
+
+					const size_t i = rng() % sd.size();
+					const size_t j = i + rng() % (sd.size() - i + 1);
+					rd.erase(rd.begin() + i, rd.begin() + j);
+					sd.erase(sd.begin() + i, sd.begin() + j);
+				} break;
+				case 6: {
+					if ((rng() % 256) != 0)
+						break;
+
+					rd.clear();
+					sd.clear();
+				} break;
+			}
+
+			REQUIRE(Equal(rd, sd));
+		}
+	}
+}
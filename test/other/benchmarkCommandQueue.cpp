@@ -0,0 +1,97 @@
+#include "Sim/Units/CommandAI/Command.h"
+#include "System/RingDeque.h"
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <random>
+
+// replays the queue traffic typical for long shift-queued build orders and
+// Lua-generated patrol routes: a burst of appends, per-frame iteration (as
+// done by CCommandAI::SlowUpdate and the command drawers), internal orders
+// being pushed to and popped from the front, and finished orders removed
+
+namespace {
+	constexpr int NUM_QUEUES = 256;
+	constexpr int NUM_FRAMES = 64;
+
+	template<typename TQueue>
+	void FillQueue(TQueue& q, std::mt19937& rng, int numCmds) {
+		for (int i = 0; i < numCmds; i++) {
+			const float3 pos = {float(rng() % 8192), 0.0f, float(rng() % 8192)};
+
+			if ((i & 1) == 0) {
+				// build order: pos + facing
+				Command c(-int(1 + rng() % 100), SHIFT_KEY, pos);
+				c.PushParam(float(rng() % 4));
+				q.push_back(c);
+			} else {
+				q.push_back(Command(CMD_PATROL, SHIFT_KEY, pos));
+			}
+		}
+	}
+
+	template<typename TQueue>
+	float SimulateFrame(TQueue& q, std::mt19937& rng) {
+		float sum = 0.0f;
+
+		// drawer / SlowUpdate style iteration
+		for (const Command& c: q) {
+			sum += c.GetParam(0);
+		}
+
+		switch (rng() % 4) {
+			case 0: {
+				// internal reclaim/repair order in front of the queue
+				q.push_front(Command(CMD_RECLAIM, INTERNAL_ORDER, float(rng() % 1000)));
+			} break;
+			case 1: {
+				if (!q.empty() && q.front().IsInternalOrder())
+					q.pop_front();
+			} break;
+			case 2: {
+				// finished a (repeating) patrol point
+				if (!q.empty()) {
+					const Command c = q.front();
+					q.pop_front();
+					q.push_back(c);
+				}
+			} break;
+			case 3: {
+				// CMD_INSERT at some position
+				if (!q.empty())
+					q.insert(q.begin() + (rng() % q.size()), Command(CMD_MOVE, 0, float3(1.0f, 2.0f, 3.0f)));
+			} break;
+		}
+
+		return sum;
+	}
+}
+
+
+template<typename TQueue>
+static void BenchCommandQueueReplay(benchmark::State& state) {
+	std::vector<TQueue> queues(NUM_QUEUES);
+
+	for (auto _ : state) {
+		std::mt19937 rng(1234);
+
+		for (TQueue& q: queues) {
+			q.clear();
+			FillQueue(q, rng, state.range(0));
+		}
+
+		for (int f = 0; f < NUM_FRAMES; f++) {
+			for (TQueue& q: queues) {
+				benchmark::DoNotOptimize(SimulateFrame(q, rng));
+			}
+		}
+
+		benchmark::ClobberMemory();
+	}
+}
+
+BENCHMARK_TEMPLATE(BenchCommandQueueReplay, std::deque<Command>)->Arg(8)->Arg(64)->Arg(512);
+BENCHMARK_TEMPLATE(BenchCommandQueueReplay, spring::RingDeque<Command>)->Arg(8)->Arg(64)->Arg(512);
+
+BENCHMARK_MAIN();
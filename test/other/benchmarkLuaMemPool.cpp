@@ -0,0 +1,201 @@
+#include "Lua/LuaMemPool.h"
+#include "System/MemPoolTypes.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// replays a Lua allocation trace against the allocators LuaMemPool used and
+// uses; set LUA_ALLOC_TRACE to a file written by LuaMemPool with
+// LMP_RECORD_ALLOC_TRACE enabled, otherwise a synthetic trace mimicking the
+// table/string churn of a typical widget is generated
+
+namespace {
+	// recorded pointers mapped to slots of the live-block array, so replaying
+	// needs no lookups
+	struct TraceOp {
+		uint32_t slot;
+		uint32_t osize;
+		uint32_t nsize;
+	};
+
+	std::vector<LuaMemPool::TraceRecord> LoadTrace(const char* fileName) {
+		std::vector<LuaMemPool::TraceRecord> records;
+		FILE* f = fopen(fileName, "rb");
+
+		if (f == nullptr)
+			return records;
+
+		LuaMemPool::TraceRecord r;
+
+		while (fread(&r, sizeof(r), 1, f) == 1) {
+			records.push_back(r);
+		}
+
+		fclose(f);
+		return records;
+	}
+
+	std::vector<LuaMemPool::TraceRecord> MakeTrace() {
+		std::vector<LuaMemPool::TraceRecord> records;
+		std::vector<LuaMemPool::TraceRecord> live;
+		std::mt19937 rng(1234);
+
+		uint64_t nextPtr = 16;
+
+		for (int i = 0; i < 500000; i++) {
+			const uint32_t op = rng() % 100;
+
+			if (op < 45 || live.empty()) {
+				// mostly strings, closures and table headers/nodes
+				const uint32_t size = (op < 40)? (16 + rng() % 64): (64 + rng() % 448);
+
+				records.push_back({0, nextPtr, 0, size});
+				live.push_back({0, nextPtr, 0, size});
+				nextPtr += 16;
+				continue;
+			}
+
+			const size_t idx = rng() % live.size();
+
+			if (op < 90) {
+				records.push_back({live[idx].nptr, 0, live[idx].nsize, 0});
+				live[idx] = live.back();
+				live.pop_back();
+				continue;
+			}
+
+			// table part growing by doubling
+			records.push_back({live[idx].nptr, nextPtr, live[idx].nsize, live[idx].nsize * 2});
+			live[idx].nptr = nextPtr;
+			live[idx].nsize *= 2;
+			nextPtr += 16;
+		}
+
+		for (const LuaMemPool::TraceRecord& r: live) {
+			records.push_back({r.nptr, 0, r.nsize, 0});
+		}
+
+		return records;
+	}
+
+	const std::vector<TraceOp>& GetTraceOps(size_t& numSlots) {
+		static std::vector<TraceOp> ops;
+		static size_t slots = 0;
+
+		if (!ops.empty()) {
+			numSlots = slots;
+			return ops;
+		}
+
+		const char* fileName = std::getenv("LUA_ALLOC_TRACE");
+		const std::vector<LuaMemPool::TraceRecord> records = (fileName != nullptr)? LoadTrace(fileName): MakeTrace();
+
+		std::unordered_map<uint64_t, uint32_t> ptrSlots;
+		std::vector<uint32_t> freeSlots;
+
+		ops.reserve(records.size());
+
+		for (const LuaMemPool::TraceRecord& r: records) {
+			uint32_t slot = 0;
+
+			if (r.optr == 0) {
+				if (freeSlots.empty()) {
+					slot = slots++;
+				} else {
+					slot = freeSlots.back();
+					freeSlots.pop_back();
+				}
+			} else {
+				const auto iter = ptrSlots.find(r.optr);
+
+				// trace started after this block was allocated
+				if (iter == ptrSlots.end())
+					continue;
+
+				slot = iter->second;
+				ptrSlots.erase(iter);
+			}
+
+			if (r.nptr != 0) {
+				ptrSlots[r.nptr] = slot;
+			} else {
+				freeSlots.push_back(slot);
+			}
+
+			ops.push_back({slot, r.osize, r.nsize});
+		}
+
+		numSlots = slots;
+		return ops;
+	}
+
+
+	struct MallocAlloc {
+		void* Realloc(void* ptr, size_t osize, size_t nsize) { return (std::realloc(ptr, nsize)); }
+		void Free(void* ptr, size_t size) { std::free(ptr); }
+	};
+
+	struct PassThroughAlloc {
+		PassThroughPool<32, 4 * (1024 * 1024)> pool;
+
+		void* Realloc(void* ptr, size_t osize, size_t nsize) { return ((ptr == nullptr)? pool.allocMem(nsize): pool.reAllocMem(ptr, nsize)); }
+		void Free(void* ptr, size_t size) { pool.freeMem(ptr); }
+	};
+
+	struct SlabAlloc {
+		SlabPool<32, 16, 64 * 1024> pool;
+
+		void* Realloc(void* ptr, size_t osize, size_t nsize) { return (pool.reAllocMem(ptr, osize, nsize)); }
+		void Free(void* ptr, size_t size) { pool.freeMem(ptr, size); }
+	};
+}
+
+
+template<typename TAlloc>
+static void BenchReplayTrace(benchmark::State& state) {
+	size_t numSlots = 0;
+
+	const std::vector<TraceOp>& ops = GetTraceOps(numSlots);
+	std::vector<void*> blocks(numSlots, nullptr);
+	std::vector<uint32_t> sizes(numSlots, 0);
+
+	for (auto _ : state) {
+		TAlloc alloc;
+
+		for (const TraceOp& op: ops) {
+			if (op.nsize == 0) {
+				alloc.Free(blocks[op.slot], op.osize);
+				blocks[op.slot] = nullptr;
+				continue;
+			}
+
+			blocks[op.slot] = alloc.Realloc(blocks[op.slot], op.osize, op.nsize);
+			sizes[op.slot] = op.nsize;
+		}
+
+		// blocks still live when the trace ended
+		for (size_t i = 0; i < numSlots; i++) {
+			if (blocks[i] == nullptr)
+				continue;
+
+			alloc.Free(blocks[i], sizes[i]);
+			blocks[i] = nullptr;
+		}
+
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * ops.size());
+}
+
+BENCHMARK_TEMPLATE(BenchReplayTrace, MallocAlloc);
+BENCHMARK_TEMPLATE(BenchReplayTrace, PassThroughAlloc);
+BENCHMARK_TEMPLATE(BenchReplayTrace, SlabAlloc);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,230 @@
+#include "Net/SyncResponseTable.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <map>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// replays CGameServer::CheckSync on a synthetic response set: every frame
+// each player answers for the newest frame it simulated (most lag a few
+// frames behind), all frames still outstanding are voted on and the ones
+// with a complete response set are dropped; a handful of players is kept
+// desynced to exercise the grouping
+
+namespace {
+	constexpr int NUM_FRAMES = 256;
+	constexpr int MAX_LAG_FRAMES = 8;
+	constexpr int MAX_PLAYERS = 251;
+
+	struct Response {
+		int recvFrameNum;
+		int frameNum;
+		int playerNum;
+		unsigned checksum;
+	};
+
+	std::vector<Response> MakeResponses(int numPlayers) {
+		std::vector<Response> responses;
+
+		responses.reserve(NUM_FRAMES * numPlayers);
+
+		for (int f = 1; f <= NUM_FRAMES; f++) {
+			for (int p = 0; p < numPlayers; p++) {
+				const int frameNum = f - (p * 7) % MAX_LAG_FRAMES;
+
+				if (frameNum < 1)
+					continue;
+
+				// every 16th player is desynced
+				responses.push_back({f, frameNum, p, (frameNum * 2654435761u) ^ (((p & 15) == 0)? p: 0)});
+			}
+		}
+
+		return responses;
+	}
+
+
+	// the previous implementation: per-player hash-maps, linear checksum scan, std::map groups
+	struct MapCheckSync {
+		std::vector< std::unordered_map<int, unsigned> > syncResponse;
+		std::vector<int> outstandingFrames;
+
+		MapCheckSync(int numPlayers): syncResponse(numPlayers) {}
+
+		void AddResponse(const Response& r) {
+			if (std::find(outstandingFrames.begin(), outstandingFrames.end(), r.frameNum) != outstandingFrames.end())
+				syncResponse[r.playerNum][r.frameNum] = r.checksum;
+		}
+
+		size_t CheckSync() {
+			std::vector< std::pair<unsigned, unsigned> > checksums;
+			std::map<unsigned, std::vector<int> > desyncGroups;
+			size_t numDesynced = 0;
+
+			for (auto it = outstandingFrames.begin(); it != outstandingFrames.end(); ) {
+				const int frameNum = *it;
+
+				unsigned correctChecksum = 0;
+				unsigned maxChecksumCount = 0;
+				bool completeResponseSet = true;
+
+				checksums.clear();
+
+				for (const auto& responses: syncResponse) {
+					const auto pit = responses.find(frameNum);
+
+					if (pit == responses.end())
+						continue;
+
+					bool checksumFound = false;
+
+					for (auto& c: checksums) {
+						if (c.first != pit->second)
+							continue;
+
+						checksumFound = true;
+
+						if (maxChecksumCount < (++c.second)) {
+							maxChecksumCount = c.second;
+							correctChecksum = c.first;
+						}
+					}
+
+					if (checksumFound)
+						continue;
+
+					checksums.emplace_back(pit->second, 1);
+
+					if (maxChecksumCount == 0) {
+						maxChecksumCount = 1;
+						correctChecksum = pit->second;
+					}
+				}
+
+				desyncGroups.clear();
+
+				for (size_t p = 0; p < syncResponse.size(); p++) {
+					const auto pit = syncResponse[p].find(frameNum);
+
+					if (pit == syncResponse[p].end()) {
+						completeResponseSet = false;
+						continue;
+					}
+
+					if (pit->second != correctChecksum)
+						desyncGroups[pit->second].push_back(p);
+				}
+
+				numDesynced += desyncGroups.size();
+
+				if (completeResponseSet) {
+					for (auto& responses: syncResponse)
+						responses.erase(frameNum);
+
+					it = outstandingFrames.erase(it);
+					continue;
+				}
+
+				++it;
+			}
+
+			return numDesynced;
+		}
+	};
+
+	struct TableCheckSync {
+		CSyncResponseTable syncResponses;
+		std::vector<int> outstandingFrames;
+		std::vector<std::uint8_t> voters;
+
+		TableCheckSync(int numPlayers): syncResponses(MAX_PLAYERS), voters(numPlayers, 1) {}
+
+		void AddResponse(const Response& r) {
+			syncResponses.AddResponse(r.frameNum, r.playerNum, r.checksum);
+		}
+
+		size_t CheckSync() {
+			std::vector< std::pair<unsigned, int> > desyncGroups;
+			size_t numDesynced = 0;
+
+			desyncGroups.reserve(voters.size());
+
+			for (auto it = outstandingFrames.begin(); it != outstandingFrames.end(); ) {
+				const int frameNum = *it;
+
+				std::uint32_t correctChecksum = 0;
+				bool completeResponseSet = true;
+
+				syncResponses.FindMajority(frameNum, voters, correctChecksum);
+				desyncGroups.clear();
+
+				for (size_t p = 0; p < voters.size(); p++) {
+					std::uint32_t checksum = 0;
+
+					if (!syncResponses.GetResponse(frameNum, p, checksum)) {
+						completeResponseSet = false;
+						continue;
+					}
+
+					if (checksum != correctChecksum)
+						desyncGroups.emplace_back(checksum, p);
+				}
+
+				std::sort(desyncGroups.begin(), desyncGroups.end());
+
+				for (size_t i = 0, j = 0; i < desyncGroups.size(); i = j, numDesynced++) {
+					for (j = i; j < desyncGroups.size() && desyncGroups[j].first == desyncGroups[i].first; j++) {
+					}
+				}
+
+				if (completeResponseSet) {
+					syncResponses.RemoveFrame(frameNum);
+
+					it = outstandingFrames.erase(it);
+					continue;
+				}
+
+				++it;
+			}
+
+			return numDesynced;
+		}
+	};
+}
+
+
+template<typename TCheckSync>
+static void BenchCheckSync(benchmark::State& state) {
+	const int numPlayers = state.range(0);
+	const std::vector<Response> responses = MakeResponses(numPlayers);
+
+	for (auto _ : state) {
+		TCheckSync checkSync(numPlayers);
+
+		size_t numDesynced = 0;
+		size_t responseIdx = 0;
+
+		for (int f = 1; f <= NUM_FRAMES; f++) {
+			checkSync.outstandingFrames.push_back(f);
+
+			if constexpr (std::is_same_v<TCheckSync, TableCheckSync>)
+				checkSync.syncResponses.AddFrame(f);
+
+			for (; responseIdx < responses.size() && responses[responseIdx].recvFrameNum <= f; responseIdx++) {
+				checkSync.AddResponse(responses[responseIdx]);
+			}
+
+			numDesynced += checkSync.CheckSync();
+		}
+
+		benchmark::DoNotOptimize(numDesynced);
+	}
+}
+
+BENCHMARK_TEMPLATE(BenchCheckSync, MapCheckSync)->Arg(16)->Arg(64)->Arg(200);
+BENCHMARK_TEMPLATE(BenchCheckSync, TableCheckSync)->Arg(16)->Arg(64)->Arg(200);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,74 @@
+function widget:GetInfo()
+return {
+	name    = "GC-SpatialQueries",
+	desc    = "Compares Lua garbage produced by the GetUnitsIn* result modes",
+	author  = "spring",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = false,
+}
+end
+
+-- every <modeSeconds> switches between allocating a new result table per call,
+-- refilling one output table and visiting units through a callback; the KB
+-- allocated per second by each mode is what the collector has to chase later
+
+local modeSeconds = 10
+local queriesPerUpdate = 50
+local radius = 2000
+
+local modes = {"newtable", "outtable", "callback"}
+local modeIdx = 1
+local modeTimer
+local allocatedKB = 0
+local lastCount
+
+local outTable = {}
+local numVisited = 0
+local function Visit(unitID)
+	numVisited = numVisited + 1
+end
+
+local function RunQueries(mode)
+	local x = Game.mapSizeX * 0.5
+	local z = Game.mapSizeZ * 0.5
+
+	for i = 1, queriesPerUpdate do
+		if mode == "newtable" then
+			local units = Spring.GetUnitsInCylinder(x, z, radius)
+			numVisited = numVisited + #units
+		elseif mode == "outtable" then
+			Spring.GetUnitsInCylinder(x, z, radius, nil, outTable)
+			numVisited = numVisited + #outTable
+		else
+			Spring.GetUnitsInCylinder(x, z, radius, nil, Visit)
+		end
+	end
+end
+
+function widget:Initialize()
+	modeTimer = Spring.GetTimer()
+	lastCount = collectgarbage("count")
+end
+
+function widget:Update()
+	RunQueries(modes[modeIdx])
+
+	-- count only growth, drops are collections
+	local count = collectgarbage("count")
+	allocatedKB = allocatedKB + math.max(0, count - lastCount)
+	lastCount = count
+
+	local elapsed = Spring.DiffTimers(Spring.GetTimer(), modeTimer)
+	if elapsed < modeSeconds then
+		return
+	end
+
+	Spring.Echo(string.format("[GC-SpatialQueries] %-8s %8.1f KB/s allocated (%d unitIDs visited)", modes[modeIdx], allocatedKB / elapsed, numVisited))
+
+	modeIdx = (modeIdx % #modes) + 1
+	modeTimer = Spring.GetTimer()
+	allocatedKB = 0
+	numVisited = 0
+end
@@ -3,8 +3,15 @@
 #include <string>
 #include <map>
 #include <iostream>
+#include <fstream>
 #include <gflags/gflags.h>
 #include <iomanip> //hex
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+#include <vector>
 
 #include "StringSerializer.h"
 
@@ -19,6 +26,15 @@ Start with the full! path to the demofile as the only argument
 
 Please note that not all NETMSG's are implemented, expand if needed.
 
+With --verifydir, every demo in the given directory is replayed by a headless
+engine (--engine, started with --benchmark so it runs at unlimited speed) on
+--jobs cores in parallel. The engine compares its own checksums against the
+NETMSG_SYNCRESPONSE packets recorded in the demo (this requires a SYNCCHECK
+build), DemoTool collects the first desynced frame of each demo into a summary.
+A demo only counts as ok if the engine exited cleanly, simulated every frame
+of the demo and reports that it actually compared checksums; without the
+latter it is listed as unverified.
+
 When compiling for windows with MinGW, make sure to use the
 -Wl,-subsystem,console flag when linking, as otherwise there will be
 no console output (you still could use this.exe > z.tzt though).
@@ -32,10 +48,17 @@ no console output (you still could use this.exe > z.tzt though).
 	DEFINE_bool  (teamstats,    false, "Print teamstats");
 	DEFINE_int32 (team,         -1,    "Select team");
 	DEFINE_string(teamsstatcsv, "",    "Write teamstats in a csv file");
+	DEFINE_string(verifydir,    "",    "Replay all demos in this directory and report the first desynced frame of each");
+	DEFINE_string(verifyout,    "",    "Directory for engine logs and timings of --verifydir (default: <verifydir>/verify)");
+	DEFINE_string(verifyreport, "",    "Write the --verifydir summary to this csv file");
+	DEFINE_string(engine,       "spring-headless", "Engine binary used by --verifydir");
+	DEFINE_string(engineargs,   "",    "Extra arguments passed to each engine instance started by --verifydir");
+	DEFINE_int32 (jobs,         0,     "Number of demos --verifydir replays in parallel (0 = one per core)");
 
 
 void TrafficDump(CDemoReader& reader, bool trafficStats);
 void WriteTeamstatHistory(CDemoReader& reader, unsigned team, const std::string& file);
+int VerifyDemos(const std::string& demoDir);
 
 int main (int argc, char* argv[])
 {
@@ -43,6 +66,9 @@ int main (int argc, char* argv[])
 
 	gflags::SetUsageMessage(std::string("Usage: ") + argv[0] + " [options] path_to_demo.sdfz");
 	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (!FLAGS_verifydir.empty())
+		return VerifyDemos(FLAGS_verifydir);
+
 	if (!FLAGS_demofile.empty()) {
 		filename = FLAGS_demofile;
 	} else if (argc >= 2) {
@@ -504,3 +530,212 @@ void WriteTeamstatHistory(CDemoReader& reader, unsigned team, const std::string&
 		exit(1);
 	}
 };
+
+
+struct DemoVerifyResult
+{
+	std::string demoFile;
+	std::string status = "failed";
+
+	int exitCode = -1;
+	int demoFrames = 0;
+	int syncResponses = 0;
+	int simFrames = -1;
+	int firstDesyncFrame = -1;
+};
+
+static std::string Quote(const std::string& str)
+{
+	return ("\"" + str + "\"");
+}
+
+// extracts <"key": value> from the engine's benchmark json
+static int ReadJsonInt(const std::string& json, const std::string& key, int defValue)
+{
+	const std::string pattern = Quote(key) + ":";
+	const size_t pos = json.find(pattern);
+
+	if (pos == std::string::npos)
+		return defValue;
+
+	return std::atoi(json.c_str() + pos + pattern.size());
+}
+
+static bool ReadJsonBool(const std::string& json, const std::string& key, bool defValue)
+{
+	const std::string pattern = Quote(key) + ":";
+	const size_t pos = json.find(pattern);
+
+	if (pos == std::string::npos)
+		return defValue;
+
+	const size_t valuePos = json.find_first_not_of(" \t", pos + pattern.size());
+
+	if (valuePos == std::string::npos)
+		return defValue;
+
+	return (json.compare(valuePos, 4, "true") == 0);
+}
+
+// counts the frames and sync-responses recorded in the demo; a demo without
+// the latter can be replayed but not verified (recorded by a non-SYNCCHECK build)
+static bool ScanDemo(DemoVerifyResult& result)
+{
+	try {
+		CDemoReader reader(result.demoFile, 0.0f);
+
+		while (!reader.ReachedEnd()) {
+			netcode::RawPacket* packet = reader.GetData(3.402823466e+38f);
+
+			if (packet == nullptr)
+				continue;
+
+			if (packet->length > 0) {
+				switch (packet->data[0]) {
+					case NETMSG_NEWFRAME:
+					case NETMSG_KEYFRAME: { result.demoFrames += 1; } break;
+					case NETMSG_SYNCRESPONSE: { result.syncResponses += 1; } break;
+					default: {} break;
+				}
+			}
+
+			delete packet;
+		}
+	} catch (const std::exception& ex) {
+		result.status = std::string("unreadable (") + ex.what() + ")";
+		return false;
+	}
+
+	return true;
+}
+
+static void VerifyDemo(DemoVerifyResult& result, const std::filesystem::path& outDir)
+{
+	if (!ScanDemo(result))
+		return;
+
+	const std::string outName = (outDir / std::filesystem::path(result.demoFile).stem()).string();
+	const std::string command =
+		Quote(FLAGS_engine) +
+		" --benchmark " + Quote(outName) + " " +
+		FLAGS_engineargs + " " +
+		Quote(result.demoFile) +
+		" > " + Quote(outName + ".log") + " 2>&1";
+
+	// results of an earlier run must not be mistaken for this one's
+	std::error_code ec;
+	std::filesystem::remove(outName + ".json", ec);
+
+	result.exitCode = std::system(command.c_str());
+
+	if (result.exitCode != 0)
+		return;
+
+	std::ifstream jsonFile(outName + ".json");
+
+	if (!jsonFile.is_open())
+		return;
+
+	const std::string json((std::istreambuf_iterator<char>(jsonFile)), std::istreambuf_iterator<char>());
+
+	result.simFrames = ReadJsonInt(json, "frames", -1);
+	result.firstDesyncFrame = ReadJsonInt(json, "firstDesyncFrame", -1);
+
+	if (result.firstDesyncFrame >= 0) {
+		result.status = "desync";
+	} else if (result.simFrames < result.demoFrames) {
+		result.status = "incomplete";
+	} else if (!ReadJsonBool(json, "syncCheck", false)) {
+		// non-SYNCCHECK engine, or a demo without sync-responses from others
+		result.status = "unverified";
+	} else {
+		result.status = "ok";
+	}
+}
+
+int VerifyDemos(const std::string& demoDir)
+{
+	namespace fs = std::filesystem;
+
+	std::vector<DemoVerifyResult> results;
+	std::error_code ec;
+
+	for (const fs::directory_entry& entry: fs::directory_iterator(demoDir, ec)) {
+		if (!entry.is_regular_file() || entry.path().extension() != ".sdfz")
+			continue;
+
+		results.emplace_back();
+		results.back().demoFile = entry.path().string();
+	}
+
+	if (ec || results.empty()) {
+		std::cout << "No demos found in " << demoDir << std::endl;
+		return 1;
+	}
+
+	std::sort(results.begin(), results.end(), [](const DemoVerifyResult& a, const DemoVerifyResult& b) { return (a.demoFile < b.demoFile); });
+
+	const fs::path outDir = FLAGS_verifyout.empty()? (fs::path(demoDir) / "verify"): fs::path(FLAGS_verifyout);
+	fs::create_directories(outDir, ec);
+
+	const unsigned numJobs = std::clamp((FLAGS_jobs > 0)? unsigned(FLAGS_jobs): std::thread::hardware_concurrency(), 1u, unsigned(results.size()));
+
+	std::cout << "Verifying " << results.size() << " demos with " << numJobs << " jobs, output in " << outDir.string() << std::endl;
+
+	// each worker starts one engine process at a time
+	std::atomic<size_t> nextDemo = {0};
+	std::vector<std::thread> workers;
+
+	for (unsigned n = 0; n < numJobs; n++) {
+		workers.emplace_back([&]() {
+			for (size_t i = nextDemo++; i < results.size(); i = nextDemo++) {
+				VerifyDemo(results[i], outDir);
+			}
+		});
+	}
+
+	for (std::thread& worker: workers) {
+		worker.join();
+	}
+
+	std::map<std::string, int> statusCounts;
+
+	for (const DemoVerifyResult& result: results) {
+		statusCounts[result.status] += 1;
+
+		if (result.status == "ok")
+			continue;
+
+		std::cout << std::setw(12) << std::left << result.status << " " << result.demoFile;
+
+		if (result.firstDesyncFrame >= 0)
+			std::cout << " (first desync at frame " << result.firstDesyncFrame << ")";
+
+		std::cout << std::endl;
+	}
+
+	std::cout << "Summary:";
+
+	for (const auto& statusCount: statusCounts) {
+		std::cout << " " << statusCount.first << "=" << statusCount.second;
+	}
+
+	std::cout << std::endl;
+
+	if (!FLAGS_verifyreport.empty()) {
+		std::ofstream out(FLAGS_verifyreport.c_str());
+		out << "demo;status;firstDesyncFrame;demoFrames;simFrames;syncResponses;exitCode" << std::endl;
+
+		for (const DemoVerifyResult& result: results) {
+			PrintSep(out, result.demoFile);
+			PrintSep(out, result.status);
+			PrintSep(out, result.firstDesyncFrame);
+			PrintSep(out, result.demoFrames);
+			PrintSep(out, result.simFrames);
+			PrintSep(out, result.syncResponses);
+			out << result.exitCode << std::endl;
+		}
+	}
+
+	return ((statusCounts.size() == statusCounts.count("ok") + statusCounts.count("unverified"))? 0: 2);
+}
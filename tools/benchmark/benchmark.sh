@@ -1,34 +1,34 @@
 #!/bin/bash
 
+# A/B simulation benchmark: plays the same demo back with each engine
+# (headless builds) at unlimited speed, every run writes per-frame timings
+# (<run>.csv) and per-section percentiles (<run>.json) of the Sim:: timers
+#
+# usage: benchmark.sh demo.sdfz [spring-headless binaries...]
+
 set -e
 
 TESTRUNS=4
 
-CMD[0]="./spring_pic --benchmark 20 --benchmarkstart 0"
-CMD[1]="./spring_nonpic --benchmark 20 --benchmarkstart 0"
-CMD[2]="./spring_mt --benchmark 20 --benchmarkstart 0"
+DEMOFILE="$1"
+shift
+
+if [ -z "$DEMOFILE" ] || ! [ -s "$DEMOFILE" ]; then
+	echo "usage: $0 demo.sdfz [spring-headless ...]"
+	exit 1
+fi
 
-#CMD1=$CMD2
+CMD=("$@")
 
-SCRIPT="script_benchmark.txt"
-#SCRIPT="script_benchmark_zwzsg.txt"
-#SCRIPT="demos/20121114_033937_TheHunters-v3_91.0.1-368-gbca8185 develop.sdf"
-DEMOFILE=bench_results_2012-11-20_10-33-36/benchmark.sdf
+if [ ${#CMD[*]} -eq 0 ]; then
+	CMD[0]="./spring-headless"
+fi
 
 PREFIX=$PWD/bench_results_$(date +"%Y-%m-%d_%H-%M-%S")
 
 
 mkdir "$PREFIX"
-
-if ! [ -s "$DEMOFILE" ]; then
-	echo Creating demo
-	${CMD[0]} "$SCRIPT" >/dev/null 2>&1 &
-	wait
-	DEMOFILE=`cat infolog.txt | grep "Writing demo: " | cut -c27-`
-	echo demo file: $DEMOFILE
-	cp -v "$DEMOFILE" "$PREFIX/benchmark.sdf"
-	mv benchmark.data "$PREFIX/data-0-cmd1.data"
-fi
+cp -v "$DEMOFILE" "$PREFIX/benchmark.sdfz"
 
 
 CMDCOUNT=${#CMD[*]}
@@ -36,8 +36,7 @@ for (( i=1; i <= TESTRUNS; i++ )); do
 	echo Round $i/$TESTRUNS
 	for (( k=0; k < $CMDCOUNT; k++ )); do
 		echo Running CMD $(($k+1))/$CMDCOUNT
-		${CMD[$k]} "$DEMOFILE" >/dev/null 2>&1
-		mv benchmark.data "$PREFIX/data-${i}-cmd${k}.data"
+		${CMD[$k]} --benchmark "$PREFIX/data-${i}-cmd${k}" "$PREFIX/benchmark.sdfz" >/dev/null 2>&1
 	done
 done
 